@@ -40,6 +40,10 @@ class OctoNyteRV32ICoreIO(val numThreads: Int, val fetchWidth: Int) extends Bund
   val debugCtrlIsBranch = Output(Bool())
   val debugCtrlIsJal    = Output(Bool())
   val debugCtrlIsJalr   = Output(Bool())
+  // Register write committed by the WB-stage instruction described by debugCtrl*
+  val debugWbWrite      = Output(Bool())
+  val debugWbRd         = Output(UInt(5.W))
+  val debugWbData       = Output(UInt(32.W))
   val debugExecValid    = Output(Bool())
   val debugExecThread   = Output(UInt(threadBits.W))
   val debugExecPC       = Output(UInt(32.W))
@@ -570,6 +574,9 @@ class OctoNyteRV32ICore extends Module {
   io.debugCtrlIsBranch := wbDecodeSignals.isBranch
   io.debugCtrlIsJal := wbDecodeSignals.isJAL
   io.debugCtrlIsJalr := wbDecodeSignals.isJALR
+  io.debugWbWrite := wbDoWrite
+  io.debugWbRd := wbRd
+  io.debugWbData := exec3ToWbEntry.exec2Signals.exec1Signals.result
 
   io.debugExecValid := exec1DebugValid
   io.debugExecThread := exec1ThreadSel
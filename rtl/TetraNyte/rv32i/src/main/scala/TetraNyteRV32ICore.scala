@@ -61,6 +61,16 @@ class TetraNyteRV32ICoreIO(val numThreads: Int) extends Bundle {
   val ctrlIsJal = Output(Bool())
   val ctrlIsJalr = Output(Bool())
   val ctrlIsBranch = Output(Bool())
+
+  // Writeback visibility: the instruction in WB this cycle and the register
+  // write it commits at the next clock edge (used for lockstep co-simulation)
+  val wbValid = Output(Bool())
+  val wbThread = Output(UInt(log2Ceil(numThreads).W))
+  val wbPC = Output(UInt(32.W))
+  val wbInstr = Output(UInt(32.W))
+  val wbWrite = Output(Bool())
+  val wbRd = Output(UInt(5.W))
+  val wbData = Output(UInt(32.W))
 }
 
 class TetraNyteRV32ICore extends Module {
@@ -402,6 +412,13 @@ class TetraNyteRV32ICore extends Module {
   io.id_rs2Data := debugIdRs2
   io.ex_aluResult := debugExAlu
   io.mem_loadData := debugMemLoad
+  io.wbValid := mem_wb.valid && io.threadEnable(mem_wb.threadId)
+  io.wbThread := mem_wb.threadId
+  io.wbPC := mem_wb.pc
+  io.wbInstr := mem_wb.instr
+  io.wbWrite := writeEnable
+  io.wbRd := mem_wb.rd
+  io.wbData := wbData
   // Default debug outputs when no control transfer
   when(!io.ctrlTaken) {
     io.ctrlThread := 0.U
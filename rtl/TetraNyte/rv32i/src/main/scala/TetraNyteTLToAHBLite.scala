@@ -17,6 +17,11 @@ class TetraNyteTLToAHBLite(tlParams: TLParams = TLParams(),
       val writeData = Input(UInt(32.W))
       val writeMask = Input(UInt(4.W))
       val readData  = Output(UInt(32.W))
+      // Handshake visibility for bus-level testbenches: a request is taken on a
+      // cycle with valid && ready, and readData carries its response on a cycle
+      // with respValid.
+      val ready     = Output(Bool())
+      val respValid = Output(Bool())
     }
 
     val passthroughMem = new Bundle {
@@ -37,6 +42,8 @@ class TetraNyteTLToAHBLite(tlParams: TLParams = TLParams(),
   memPort.io.legacy.writeData := io.legacy.writeData
   memPort.io.legacy.writeMask := io.legacy.writeMask
   io.legacy.readData := memPort.io.legacy.readData
+  io.legacy.ready := bridge.io.tl.a.ready
+  io.legacy.respValid := bridge.io.tl.d.valid
 
   io.passthroughMem.addr := memPort.io.passthroughMem.addr
   io.passthroughMem.writeData := memPort.io.passthroughMem.writeData
@@ -27,6 +27,9 @@ class ZeroNyteRV32ICore extends Module {
     val pc_out    = Output(UInt(32.W))
     val instr_out = Output(UInt(32.W))
     val result    = Output(UInt(32.W))
+    val retire    = Output(Bool())     // instr_out completes this cycle
+    val rd_wen    = Output(Bool())     // it writes `result` to a register
+    val rd_addr   = Output(UInt(5.W))
   })
 
   // ---------- Program Counter ----------
@@ -294,4 +297,9 @@ class ZeroNyteRV32ICore extends Module {
   }
 
   pc := nextPC
+
+  // A DIV/REM holds the PC while it iterates and retires on its last cycle.
+  io.retire  := !divStall
+  io.rd_wen  := doWrite && targetRd =/= 0.U
+  io.rd_addr := targetRd
 }
@@ -21,8 +21,8 @@ import Decoders.RV32IDecodeModule
 import LoadUnit.LoadUnit
 import RegFiles.RegFileMT2R1WVec
 import StoreUnit.StoreUnit
-import TetraNyte.TetraNyteRV32ICore
-import ZeroNyte.ZeroNyteRV32ICore
+import TetraNyte.{TetraNyteRV32ICore, TetraNyteTLToAHBLite, TetraNyteTLToAXI4Lite}
+import ZeroNyte.{ZeroNyteMemPort, ZeroNyteRV32ICore}
 import OctoNyte.OctoNyteRV32ICore
 
 // Note: RV32IDecode is an object (not a Module class), so it's not imported for RTL generation
@@ -289,7 +289,8 @@ Environment Variables:
     variant match {
       case "rv32i" =>
         getRV32ILibraryModules("ZeroNyte") :+
-          ModuleSpec(() => new ZeroNyteRV32ICore, "ZeroNyteRV32ICore", "Single-cycle RV32I core", "ZeroNyte", "rv32i")
+          ModuleSpec(() => new ZeroNyteRV32ICore, "ZeroNyteRV32ICore", "Single-cycle RV32I core", "ZeroNyte", "rv32i") :+
+          ModuleSpec(() => new ZeroNyteMemPort, "ZeroNyteMemPort", "Legacy memory view to TileLink-UL master", "ZeroNyte", "rv32i")
       case _ => Seq.empty
     }
   }
@@ -305,7 +306,9 @@ Environment Variables:
         // Generate all building blocks plus the threaded core itself
         val libraryBlocks = getRV32ILibraryModules("TetraNyte")
         libraryBlocks :+
-          ModuleSpec(() => new TetraNyteRV32ICore, "TetraNyteRV32ICore", "Four-thread barrel-threaded RV32I core", "TetraNyte", "rv32i")
+          ModuleSpec(() => new TetraNyteRV32ICore, "TetraNyteRV32ICore", "Four-thread barrel-threaded RV32I core", "TetraNyte", "rv32i") :+
+          ModuleSpec(() => new TetraNyteTLToAXI4Lite, "TetraNyteTLToAXI4Lite", "Legacy memory view to AXI4-Lite master", "TetraNyte", "rv32i") :+
+          ModuleSpec(() => new TetraNyteTLToAHBLite, "TetraNyteTLToAHBLite", "Legacy memory view to AHB-Lite master", "TetraNyte", "rv32i")
       case _ => Seq.empty
     }
   }
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Simulator throughput benchmark.
+
+Builds the requested simulator flavors, assembles the workloads in workloads/
+and runs each one on each core, reporting wall time, simulated cycles per
+second and peak RSS as JSON. Every run goes through ``--batch`` with a
+one-entry manifest, so the harness's own ``result`` line supplies the cycle
+count and the simulation wall time, excluding process start-up and ELF
+parsing.
+
+Usage: run_bench.py [--cores zeronyte,tetranyte,octonyte] [--flavors debug,fast]
+                    [--scale N] [--skip-build] [--output bench.json]
+
+RISCV_PREFIX (default riscv64-unknown-elf-) selects the toolchain.
+"""
+
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import time
+from typing import Dict, List, Optional
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_ROOT = os.path.dirname(os.path.dirname(SCRIPT_DIR))
+SIM_DIR = os.path.join(REPO_ROOT, "tests", "sim")
+sys.path.insert(0, os.path.join(REPO_ROOT, "tests", "riscof"))
+
+import nyte_batch  # noqa: E402
+
+CORES = ["zeronyte", "tetranyte", "octonyte"]
+NUM_THREADS = {"zeronyte": 1, "tetranyte": 4, "octonyte": 8}
+
+# (name, source, thread mask, cores it runs on)
+WORKLOADS = [
+    ("alu_loop", "alu_loop.S", 0x1, CORES),
+    ("mem_sweep", "mem_sweep.S", 0x1, CORES),
+    ("branch_loop", "branch_loop.S", 0x1, CORES),
+    ("alu_loop_8t", "alu_loop.S", 0xFF, ["octonyte"]),
+]
+
+MAX_CYCLES = 500_000_000
+
+
+def sim_path(core: str, flavor: str) -> str:
+    suffix = "" if flavor == "debug" else "_" + flavor
+    return os.path.join(SIM_DIR, "build", f"{core}_sim{suffix}")
+
+
+def build_sim(core: str, flavor: str) -> None:
+    env = dict(os.environ, SIM_FLAVOR=flavor)
+    script = os.path.join(SIM_DIR, f"build_{core}_sim.sh")
+    subprocess.run([script], env=env, check=True, stdout=sys.stderr)
+
+
+def assemble(source: str, elf: str, scale: int) -> None:
+    gcc = os.environ.get("RISCV_PREFIX", "riscv64-unknown-elf-") + "gcc"
+    subprocess.run(
+        [
+            gcc, "-march=rv32i", "-mabi=ilp32", "-static", "-nostdlib", "-nostartfiles",
+            "-T", os.path.join(SCRIPT_DIR, "link.ld"),
+            "-I", os.path.join(SCRIPT_DIR, "workloads"),
+            f"-DSCALE={scale}",
+            os.path.join(SCRIPT_DIR, "workloads", source),
+            "-o", elf,
+        ],
+        check=True,
+    )
+
+
+def run_one(sim: str, elf: str, thread_mask: int, work_dir: str, name: str) -> Dict:
+    """Runs one workload and returns its measurements."""
+    manifest = os.path.join(work_dir, name + ".manifest")
+    nyte_batch.write_manifest(
+        manifest, [(elf, os.path.join(work_dir, name + ".sig"), MAX_CYCLES, "")])
+    cmd = [sim, "--batch", manifest, "--hang-cycles", "0"]
+    if thread_mask != 0x1:
+        cmd += ["--thread-mask", hex(thread_mask)]
+
+    out_path = os.path.join(work_dir, name + ".out")
+    with open(out_path, "w") as out:
+        start = time.perf_counter()
+        proc = subprocess.Popen(cmd, stdout=out, stderr=subprocess.STDOUT)
+        # wait4 rather than Popen.wait so the child's own peak RSS is reported.
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+
+    result: Optional[Dict[str, str]] = None
+    with open(out_path) as out:
+        for line in out:
+            result = nyte_batch.parse_result(line) or result
+    exit_code = int(result["exit"]) if result else proc.returncode
+    cycles = int(result["cycles"]) if result else 0
+    sim_seconds = float(result["wall_ms"]) / 1e3 if result else wall
+    return {
+        "exit": exit_code,
+        "cycles": cycles,
+        "wall_s": round(wall, 6),
+        "sim_s": round(sim_seconds, 6),
+        "cycles_per_sec": round(cycles / sim_seconds) if sim_seconds > 0 else 0,
+        "peak_rss_kb": usage.ru_maxrss,  # kilobytes on Linux
+    }
+
+
+def git_revision() -> str:
+    try:
+        return subprocess.run(
+            ["git", "-C", REPO_ROOT, "describe", "--always", "--dirty"],
+            check=True, capture_output=True, text=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cores", default=",".join(CORES))
+    parser.add_argument("--flavors", default="debug,fast")
+    parser.add_argument("--scale", type=int, default=1,
+                        help="multiplies every workload's iteration count")
+    parser.add_argument("--skip-build", action="store_true",
+                        help="use the simulators already in tests/sim/build")
+    parser.add_argument("--output", help="write the JSON report here instead of stdout")
+    args = parser.parse_args()
+
+    cores = [c for c in args.cores.split(",") if c]
+    flavors = [f for f in args.flavors.split(",") if f]
+    unknown = [c for c in cores if c not in CORES]
+    if unknown:
+        parser.error("unknown core(s): " + ", ".join(unknown))
+
+    runs: List[Dict] = []
+    failed = False
+    with tempfile.TemporaryDirectory(prefix="nyte_bench_") as work_dir:
+        elfs = {}
+        for _, source, _, _ in WORKLOADS:
+            if source not in elfs:
+                elfs[source] = os.path.join(work_dir, os.path.splitext(source)[0] + ".elf")
+                assemble(source, elfs[source], args.scale)
+
+        for flavor in flavors:
+            for core in cores:
+                if not args.skip_build:
+                    build_sim(core, flavor)
+                sim = sim_path(core, flavor)
+                for name, source, mask, on_cores in WORKLOADS:
+                    if core not in on_cores:
+                        continue
+                    tag = f"{core}_{flavor}_{name}"
+                    print(f"Running {tag}", file=sys.stderr)
+                    run = {
+                        "core": core,
+                        "flavor": flavor,
+                        "workload": name,
+                        "threads": bin(mask & ((1 << NUM_THREADS[core]) - 1)).count("1"),
+                    }
+                    run.update(run_one(sim, elfs[source], mask, work_dir, tag))
+                    if run["exit"] != 0:
+                        print(f"{tag} exited with {run['exit']}", file=sys.stderr)
+                        failed = True
+                    runs.append(run)
+
+    report = {
+        "revision": git_revision(),
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "cpus": os.cpu_count(),
+        "scale": args.scale,
+        "runs": runs,
+    }
+    text = json.dumps(report, indent=2) + "\n"
+    if args.output:
+        with open(args.output, "w") as out:
+            out.write(text)
+    else:
+        sys.stdout.write(text)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,29 @@
+// Shared scaffolding for the throughput workloads. Each workload starts at
+// _start in .text.init, scales its outer loop by SCALE (set by run_bench.py)
+// and ends with BENCH_HALT, which reports a pass the way RVMODEL_HALT does.
+// run_bench.py leaves --hang-cycles off, so loops need not store to look alive.
+
+#ifndef SCALE
+#define SCALE 1
+#endif
+
+#define BENCH_HALT \
+  li t0, 1;        \
+  la t1, tohost;   \
+1:                 \
+  sw t0, 0(t1);    \
+  j 1b
+
+#define BENCH_DATA                        \
+  .section .tohost, "aw", @progbits;      \
+  .align 6;                               \
+  .global tohost;                         \
+tohost:                                   \
+  .word 0;                                \
+  .data;                                  \
+  .align 4;                               \
+  .global begin_signature;                \
+begin_signature:                          \
+  .word 0;                                \
+  .global end_signature;                  \
+end_signature:
@@ -0,0 +1,150 @@
+"""Batch execution helpers shared by the ZeroNyte, TetraNyte and OctoNyte RISCOF plugins.
+
+Instead of one simulator launch per test, the plugins write a manifest and run the
+whole suite through a single ``<sim> --batch <manifest>`` process. The simulator
+resets the DUT between entries and prints one ``result`` line per test.
+
+The simulator deals manifest entries round-robin to its workers and idle workers
+steal from the back, so a manifest sorted longest-first with ``TestHistory``
+keeps the slowest tests from starting last and stretching the tail of the run.
+"""
+
+import json
+import logging
+import os
+import subprocess
+import threading
+from typing import Callable, Dict, Iterable, List, Optional, Tuple
+
+logger = logging.getLogger()
+
+# (elf, signature, max_cycles, log)
+BatchEntry = Tuple[str, str, int, str]
+
+
+class TestHistory:
+    """Per-test cycle counts and wall times from earlier runs, kept as JSON.
+
+    Keys are RISCOF test names. A missing or unreadable file is an empty history.
+    """
+
+    def __init__(self, path: str):
+        self.path = path
+        self.tests: Dict[str, Dict[str, float]] = {}
+        try:
+            with open(path) as history:
+                loaded = json.load(history)
+            if isinstance(loaded, dict):
+                self.tests = {name: entry for name, entry in loaded.items()
+                              if isinstance(entry, dict)}
+        except (OSError, ValueError):
+            pass
+
+    def longest_first(self, names: Iterable[str]) -> List[str]:
+        """Order ``names`` by descending recorded wall time. Tests with no
+        history go first, since they may be the longest of all."""
+        def key(name: str):
+            entry = self.tests.get(name)
+            if entry is None:
+                return (0, 0.0, 0, name)
+            return (1, -float(entry.get("wall_ms", 0)), -int(entry.get("cycles", 0)), name)
+        return sorted(names, key=key)
+
+    def record(self, name: str, result: Dict[str, str]) -> None:
+        """Remember a streamed ``result``. Only tests that ran to completion
+        (exit 0) are recorded, so a timeout does not pass for a typical run."""
+        if result.get("exit") != "0":
+            return
+        try:
+            self.tests[name] = {"cycles": int(result["cycles"]),
+                                "wall_ms": float(result["wall_ms"])}
+        except (KeyError, ValueError):
+            pass
+
+    def save(self) -> None:
+        tmp = self.path + ".tmp"
+        try:
+            with open(tmp, "w") as history:
+                json.dump(self.tests, history, indent=1, sort_keys=True)
+            os.replace(tmp, self.path)
+        except OSError as err:
+            logger.warning("Cannot save test history %s: %s", self.path, err)
+
+
+def job_count(value) -> int:
+    """Parse a plugin ``jobs`` setting; 0 or ``auto`` means one per CPU."""
+    text = str(value).strip().lower()
+    jobs = 0 if text == "auto" else int(text)
+    return jobs if jobs > 0 else (os.cpu_count() or 1)
+
+
+def write_manifest(path: str, entries: Iterable[BatchEntry],
+                   expected: Optional[Dict[str, str]] = None) -> None:
+    """Write a ``--batch`` manifest. ``expected`` maps an ELF to a reference
+    signature that the simulator checks in-process (exit code 9 on a mismatch)."""
+    expected = expected or {}
+    with open(path, "w") as manifest:
+        for elf, signature, max_cycles, log in entries:
+            fields = [elf, signature, str(max_cycles)]
+            if elf in expected:
+                fields += [log or "-", expected[elf]]
+            elif log:
+                fields.append(log)
+            manifest.write(" ".join(fields) + "\n")
+
+
+def parse_result(line: str) -> Optional[Dict[str, str]]:
+    """Parse ``result exit=<n> cycles=<n> wall_ms=<t> elf=<path>``; None for other output."""
+    if not line.startswith("result "):
+        return None
+    head, sep, elf = line.rstrip("\n").partition(" elf=")
+    if not sep:
+        return None
+    fields = dict(item.split("=", 1) for item in head.split()[1:] if "=" in item)
+    fields["elf"] = elf
+    return fields
+
+
+def _stop(proc: subprocess.Popen, grace: float = 10.0) -> None:
+    proc.terminate()
+    try:
+        proc.wait(timeout=grace)
+    except subprocess.TimeoutExpired:
+        proc.kill()
+
+
+def run_batch(
+    dut_exe: str,
+    manifest: str,
+    cwd: str,
+    timeout: int,
+    on_result: Optional[Callable[[Dict[str, str]], None]] = None,
+    extra_args: Optional[List[str]] = None,
+) -> List[Dict[str, str]]:
+    """Run ``dut_exe --batch manifest`` and return the parsed result lines.
+
+    Results are handed to ``on_result`` as they stream in. Once ``timeout`` seconds
+    have elapsed the process gets SIGTERM, so flight recorders can dump, and is
+    killed if it is still alive after a grace period. Entries that never reported
+    are simply absent from the returned list.
+    """
+    cmd = [dut_exe, "--batch", manifest] + (extra_args or [])
+    logger.debug("Batch command: %s", " ".join(cmd))
+    proc = subprocess.Popen(cmd, cwd=cwd, stdout=subprocess.PIPE, text=True)
+    timer = threading.Timer(timeout, _stop, args=(proc,))
+    timer.start()
+    results = []
+    try:
+        for line in proc.stdout:
+            result = parse_result(line)
+            if result is None:
+                continue
+            results.append(result)
+            if on_result is not None:
+                on_result(result)
+        proc.wait()
+    finally:
+        timer.cancel()
+    if proc.returncode < 0:
+        logger.error("Batch simulator %s killed after %ss", os.path.basename(dut_exe), timeout)
+    return results
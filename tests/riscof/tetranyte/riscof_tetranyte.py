@@ -5,6 +5,8 @@ from typing import Dict
 import riscof.utils as utils
 from riscof.pluginTemplate import pluginTemplate
 
+import nyte_batch
+
 logger = logging.getLogger()
 
 
@@ -24,8 +26,21 @@ class tetranyte(pluginTemplate):
         if not os.path.isabs(self.dut_exe):
             self.dut_exe = os.path.abspath(self.dut_exe)
 
-        self.num_jobs = str(config.get("jobs", 1))
+        # Compile and simulation jobs; 0 or "auto" uses every CPU.
+        self.num_jobs = str(nyte_batch.job_count(config.get("jobs", 1)))
+        # Cycles of trace kept per test and written only when it fails; 0 streams
+        # a full trace for every test.
+        self.flight_recorder = str(config.get("flight_recorder", 65536))
+        # Check every retired instruction against the simulator's built-in
+        # RV32IM reference so a failing test reports where it diverged.
+        self.cosim = str(config.get("cosim", 1)) != "0"
+        # Early hang detection window in cycles (--hang-cycles); 0 leaves it off.
+        self.hang_cycles = str(config.get("hang_cycles", 0))
         self.pluginpath = os.path.abspath(config["pluginpath"])
+        # Cycle counts and wall times of earlier runs, used to start the longest
+        # tests first.
+        self.history = nyte_batch.TestHistory(
+            config.get("history", os.path.join(self.pluginpath, ".history.json")))
         self.isa_spec = os.path.abspath(config["ispec"])
         self.platform_spec = os.path.abspath(config["pspec"])
         self.target_run = config.get("target_run", "1") != "0"
@@ -49,6 +64,16 @@ class tetranyte(pluginTemplate):
         ispec = utils.load_yaml(isa_yaml)["hart0"]
         self.xlen = "64" if 64 in ispec["supported_xlen"] else "32"
 
+    def _batch_args(self):
+        args = ["--jobs", self.num_jobs]
+        if self.flight_recorder != "0":
+            args += ["--flight-recorder", self.flight_recorder]
+        if self.cosim:
+            args.append("--cosim")
+        if self.hang_cycles != "0":
+            args += ["--hang-cycles", self.hang_cycles]
+        return args
+
     def runTests(self, testList):
         make = utils.makeUtil(makefilePath=os.path.join(self.work_dir, "Makefile." + self.name[:-1]))
         make.makeCommand = "make -k -j" + self.num_jobs
@@ -58,11 +83,14 @@ class tetranyte(pluginTemplate):
         except ValueError:
             timeout = 300
 
-        for testname, testentry in testList.items():
+        batch_entries = []
+        test_by_elf = {}
+        for testname in self.history.longest_first(testList):
+            testentry = testList[testname]
             test_dir = testentry["work_dir"]
             elf_path = os.path.join(test_dir, "test.elf")
             sig_path = os.path.join(test_dir, self.name[:-1] + ".signature")
-            log_path = os.path.join(test_dir, self.name[:-1] + ".log")
+            log_path = os.path.join(test_dir, self.name[:-1] + ".trace")
 
             compile_macros = "-DXLEN=" + self.xlen
             if testentry["macros"]:
@@ -78,19 +106,30 @@ class tetranyte(pluginTemplate):
                 macros=compile_macros,
             )
 
-            if self.target_run:
-                # Barrel threading stretches execution; allow generous cycle budget.
-                run_cmd = (
-                    f"{self.dut_exe} --elf {elf_path} --signature {sig_path} "
-                    f"--log {log_path} --max-cycles 20000000"
-                )
-            else:
-                run_cmd = "echo 'target run disabled'"
-
-            execute = f"@cd {test_dir}; {compile_cmd}; {run_cmd};"
-            make.add_target(execute)
+            make.add_target(f"@cd {test_dir}; {compile_cmd};")
+            # Barrel threading stretches execution; allow generous cycle budget.
+            batch_entries.append((elf_path, sig_path, 20000000, log_path))
+            test_by_elf[elf_path] = testname
 
         make.execute_all(self.work_dir, timeout=timeout)
 
+        if self.target_run:
+            manifest = os.path.join(self.work_dir, "batch." + self.name[:-1] + ".txt")
+            nyte_batch.write_manifest(manifest, batch_entries)
+
+            def report(result):
+                testname = test_by_elf.get(result["elf"], result["elf"])
+                self.history.record(testname, result)
+                if result["exit"] == "0":
+                    logger.info("TetraNyte test %s PASSED (%s cycles, %s ms)",
+                                testname, result["cycles"], result["wall_ms"])
+                else:
+                    logger.error("TetraNyte test %s FAILED (exit %s after %s cycles)",
+                                 testname, result["exit"], result["cycles"])
+
+            nyte_batch.run_batch(self.dut_exe, manifest, self.work_dir, timeout,
+                                 on_result=report, extra_args=self._batch_args())
+            self.history.save()
+
         if not self.target_run:
             raise SystemExit(0)
@@ -17,6 +17,11 @@ Usage: $(basename "$0") [--processor <zeronyte|tetranyte|octonyte>]
 Runs RISCOF RV32I conformance for the requested processor. Defaults to ZeroNyte.
 Use --smoke-test to run a minimal ADD-only test for quicker turnaround.
 Use --timeout to override the per-invocation timeout (default: 3600s).
+Set SIM_JOBS to the number of simulator worker threads (default: nproc).
+Set SIM_FLIGHT_RECORDER to the number of trace cycles kept per test and written
+only when it fails (default: 65536; 0 writes a full trace for every test).
+Set SIM_COSIM=0 to skip checking each retired instruction against the built-in
+RV32IM reference model.
 EOF
 }
 
@@ -200,6 +205,13 @@ if $SMOKE_TEST; then
   echo "Smoke test enabled: running ${#COPIED[@]} tests: ${COPIED[*]}"
 fi
 
+# Simulator worker threads per batch run (one VerilatedContext each).
+SIM_JOBS=${SIM_JOBS:-$(nproc)}
+# Cycles of trace kept per test and dumped only on failure (0 = full traces).
+SIM_FLIGHT_RECORDER=${SIM_FLIGHT_RECORDER:-65536}
+# Lockstep co-simulation against the simulator's built-in RV32IM reference.
+SIM_COSIM=${SIM_COSIM:-1}
+
 CONFIG_GENERATED="$SCRIPT_DIR/riscof/.config.rv32i.${PROCESSOR}.ini"
 cat >"$CONFIG_GENERATED" <<EOF
 [RISCOF]
@@ -214,7 +226,9 @@ ispec=$ISA_FILE
 pspec=$PLATFORM_FILE
 PATH=../sim/build
 sim=$SIM_BINARY
-jobs=1
+jobs=$SIM_JOBS
+flight_recorder=$SIM_FLIGHT_RECORDER
+cosim=$SIM_COSIM
 
 [spike_simple]
 pluginpath=$PLUGIN_ROOT/spike_simple
@@ -292,8 +306,8 @@ else
 fi
 
 if $SMOKE_TEST && [[ "$PROCESSOR" != "octonyte" ]]; then
-  echo "[INFO] Smoke artifacts under $OUTPUT_DIR (signatures/logs):"
-  find "$OUTPUT_DIR" -type f \( -name "*.signature" -o -name "*.log" -o -name "*.elf" \) | sed 's|^|  |'
+  echo "[INFO] Smoke artifacts under $OUTPUT_DIR (signatures/traces; decode with tests/sim/build/trace_decode):"
+  find "$OUTPUT_DIR" -type f \( -name "*.signature" -o -name "*.trace" -o -name "*.elf" \) | sed 's|^|  |'
   echo "[INFO] Smoke tests executed:"
   find "$OUTPUT_DIR/src" -maxdepth 3 -mindepth 3 -type d | sed 's|^|  |'
 fi
@@ -310,7 +324,7 @@ if $SMOKE_TEST && [[ "$PROCESSOR" == "tetranyte" ]]; then
     declare -a THREAD_SIGS=()
     for tid in 0 1 2 3; do
       SIG_PATH="$OUTPUT_DIR/src/${test_name}/dut/DUT-tetranyte-rv32i.thread${tid}.signature"
-      LOG_PATH="$OUTPUT_DIR/src/${test_name}/dut/DUT-tetranyte-rv32i.thread${tid}.log"
+      LOG_PATH="$OUTPUT_DIR/src/${test_name}/dut/DUT-tetranyte-rv32i.thread${tid}.trace"
       THREAD_MASK=$((1 << tid))
       "$SCRIPT_DIR/sim/build/tetranyte_obj/VTetraNyteRV32ICore" \
         --elf "$ELF_PATH" \
@@ -116,6 +116,13 @@ fi
 OUTPUT_DIR="$SCRIPT_DIR/output/rv32m/$PROCESSOR"
 mkdir -p "$OUTPUT_DIR"
 
+# Simulator worker threads per batch run (one VerilatedContext each).
+SIM_JOBS=${SIM_JOBS:-$(nproc)}
+# Cycles of trace kept per test and dumped only on failure (0 = full traces).
+SIM_FLIGHT_RECORDER=${SIM_FLIGHT_RECORDER:-65536}
+# Lockstep co-simulation against the simulator's built-in RV32IM reference.
+SIM_COSIM=${SIM_COSIM:-1}
+
 CONFIG_GENERATED="$SCRIPT_DIR/riscof/.config.rv32m.${PROCESSOR}.ini"
 cat >"$CONFIG_GENERATED" <<EOF
 [RISCOF]
@@ -130,7 +137,9 @@ ispec=$ISA_FILE
 pspec=$PLATFORM_FILE
 PATH=../sim/build
 sim=$SIM_BINARY
-jobs=1
+jobs=$SIM_JOBS
+flight_recorder=$SIM_FLIGHT_RECORDER
+cosim=$SIM_COSIM
 
 [spike_simple]
 pluginpath=$PLUGIN_ROOT/spike_simple
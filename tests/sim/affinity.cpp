@@ -0,0 +1,40 @@
+#include "affinity.h"
+
+#include <sched.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+void pinToCpus(const std::string& cpu_list) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  std::istringstream ranges(cpu_list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    const auto dash = range.find('-');
+    size_t first = 0;
+    size_t last = 0;
+    try {
+      first = std::stoul(range.substr(0, dash));
+      last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+    } catch (const std::exception&) {
+      throw std::invalid_argument("malformed CPU list: " + cpu_list);
+    }
+    if (last < first || last >= CPU_SETSIZE) {
+      throw std::invalid_argument("CPU range out of bounds: " + range);
+    }
+    for (size_t cpu = first; cpu <= last; ++cpu) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  if (CPU_COUNT(&set) == 0) {
+    throw std::invalid_argument("empty CPU list");
+  }
+
+  if (::sched_setaffinity(0, sizeof(set), &set) != 0) {
+    throw std::runtime_error(std::string("sched_setaffinity failed: ") + std::strerror(errno));
+  }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+// Restricts the calling thread, and every thread it creates afterwards (such
+// as the Verilator model's worker pool), to the CPUs in `cpu_list`, written as
+// comma-separated indices and ranges, e.g. "0-3,8". Throws
+// std::invalid_argument on a malformed list and std::runtime_error if the
+// kernel rejects the mask.
+void pinToCpus(const std::string& cpu_list);
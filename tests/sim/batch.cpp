@@ -0,0 +1,81 @@
+#include "batch.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<BatchEntry> loadBatchManifest(const std::string& path, uint64_t default_max_cycles) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    throw std::runtime_error("failed to open batch manifest: " + path);
+  }
+
+  std::vector<BatchEntry> entries;
+  std::string line;
+  unsigned line_no = 0;
+  while (std::getline(in, line)) {
+    ++line_no;
+    std::istringstream fields(line);
+    BatchEntry entry;
+    if (!(fields >> entry.elf) || entry.elf[0] == '#') {
+      continue;
+    }
+    if (!(fields >> entry.signature)) {
+      throw std::runtime_error("batch manifest line " + std::to_string(line_no) +
+                               ": expected <elf> <signature>");
+    }
+    std::string cycles;
+    entry.max_cycles = default_max_cycles;
+    if (fields >> cycles && cycles != "-") {
+      entry.max_cycles = std::stoull(cycles);
+    }
+    if (fields >> entry.log && entry.log == "-") {
+      entry.log.clear();
+    }
+    fields >> entry.expect_signature;
+    entries.push_back(std::move(entry));
+  }
+  return entries;
+}
+
+void writeBatchResult(std::ostream& out, const BatchEntry& entry, int exit_code, uint64_t cycles,
+                      double wall_seconds) {
+  std::ostringstream line;
+  line << "result exit=" << exit_code
+       << " cycles=" << cycles
+       << " wall_ms=" << std::fixed << std::setprecision(3) << wall_seconds * 1e3
+       << " elf=" << entry.elf;
+  out << line.str() << std::endl;
+}
+
+BatchQueue::BatchQueue(size_t num_tests, unsigned workers) {
+  for (unsigned i = 0; i < workers; ++i) {
+    lanes_.push_back(std::make_unique<Lane>());
+  }
+  for (size_t index = 0; index < num_tests; ++index) {
+    lanes_[index % workers]->items.push_back(index);
+  }
+}
+
+bool BatchQueue::next(unsigned worker, size_t& index) {
+  {
+    Lane& own = *lanes_[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.items.empty()) {
+      index = own.items.front();
+      own.items.pop_front();
+      return true;
+    }
+  }
+  for (size_t offset = 1; offset < lanes_.size(); ++offset) {
+    Lane& victim = *lanes_[(worker + offset) % lanes_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.items.empty()) {
+      index = victim.items.back();
+      victim.items.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One line of a --batch manifest:
+//   <elf> <signature> [max-cycles|-] [log|-] [expected-signature]
+// Blank lines and lines starting with '#' are ignored. A missing or '-'
+// max-cycles falls back to the harness default, and '-' for the log means
+// none. An expected signature acts as --expect-signature for that test.
+struct BatchEntry {
+  std::string elf;
+  std::string signature;
+  uint64_t max_cycles = 0;
+  std::string log;
+  std::string expect_signature;
+};
+
+std::vector<BatchEntry> loadBatchManifest(const std::string& path, uint64_t default_max_cycles);
+
+// Emits "result exit=<code> cycles=<n> wall_ms=<t> elf=<path>" and flushes so
+// callers can stream results while the rest of the batch is still running.
+void writeBatchResult(std::ostream& out, const BatchEntry& entry, int exit_code, uint64_t cycles,
+                      double wall_seconds);
+
+// Work-stealing queue of manifest indices. Tests are dealt round-robin into
+// one lane per worker, in manifest order; a worker pops from the front of its
+// own lane and, once that is empty, steals from the back of the others.
+class BatchQueue {
+ public:
+  BatchQueue(size_t num_tests, unsigned workers);
+
+  bool next(unsigned worker, size_t& index);
+
+ private:
+  struct Lane {
+    std::mutex mutex;
+    std::deque<size_t> items;
+  };
+  std::vector<std::unique_ptr<Lane>> lanes_;
+};
+
+// Runs every manifest entry across `jobs` threads (0 = one per hardware
+// thread). Each thread calls `make_worker()` once to build a worker that owns
+// the thread's VerilatedContext, model and Memory, then calls
+// `run(*worker, entry, cycles)` for every test it pulls from the queue.
+// Returns 0 when every test exited 0, 1 otherwise.
+template <typename MakeWorker, typename RunFn>
+int runBatch(const std::vector<BatchEntry>& tests, unsigned jobs, MakeWorker make_worker, RunFn run) {
+  if (jobs == 0) {
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+  }
+  jobs = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(jobs, tests.size())));
+
+  BatchQueue queue(tests.size(), jobs);
+  std::mutex out_mutex;
+  std::atomic<bool> failed{false};
+
+  auto body = [&](unsigned id) {
+    auto worker = make_worker();
+    size_t index = 0;
+    while (queue.next(id, index)) {
+      const BatchEntry& test = tests[index];
+      const auto start = std::chrono::steady_clock::now();
+      uint64_t cycles = 0;
+      const int exit_code = run(*worker, test, cycles);
+      const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+      {
+        std::lock_guard<std::mutex> lock(out_mutex);
+        writeBatchResult(std::cout, test, exit_code, cycles, wall.count());
+      }
+      if (exit_code != 0) {
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned id = 1; id < jobs; ++id) {
+    threads.emplace_back(body, id);
+  }
+  body(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return failed ? 1 : 0;
+}
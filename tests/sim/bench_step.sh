@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Measures harness per-cycle overhead: builds each core's simulator from a
+# baseline revision (checked out in a temporary git worktree) and from the
+# working tree, runs both on the same --batch manifest and prints simulated
+# cycles/sec with the speedup.
+#
+# Usage: bench_step.sh <batch-manifest> [<baseline-rev>]   (default: HEAD)
+#
+# SIM_FLAVOR (default: fast) selects the build flavor and BENCH_CORES
+# (default: "zeronyte tetranyte octonyte") the cores. ELF and signature paths
+# in the manifest must be absolute, as the baseline runs from its worktree.
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+REPO_ROOT=$(cd "$SCRIPT_DIR/../.." && pwd)
+
+if [[ $# -lt 1 || $# -gt 2 ]]; then
+  echo "Usage: $(basename "$0") <batch-manifest> [<baseline-rev>]" >&2
+  exit 1
+fi
+MANIFEST=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+BASE_REV=${2:-HEAD}
+export SIM_FLAVOR=${SIM_FLAVOR:-fast}
+CORES=(${BENCH_CORES:-zeronyte tetranyte octonyte})
+
+source "$SCRIPT_DIR/sim_build.sh"
+
+suffix=""
+if [[ "$SIM_FLAVOR" != "debug" ]]; then
+  suffix="_$SIM_FLAVOR"
+fi
+
+BASE_TREE=$(mktemp -d)
+cleanup() {
+  git -C "$REPO_ROOT" worktree remove --force "$BASE_TREE" >/dev/null 2>&1 || rm -rf "$BASE_TREE"
+}
+trap cleanup EXIT
+git -C "$REPO_ROOT" worktree add --detach "$BASE_TREE" "$BASE_REV" >/dev/null
+base_label=$(git -C "$BASE_TREE" rev-parse --short HEAD)
+
+for core in "${CORES[@]}"; do
+  echo "Building $core ($SIM_FLAVOR) at $base_label and from the working tree..." >&2
+  "$BASE_TREE/tests/sim/build_${core}_sim.sh" >&2
+  "$REPO_ROOT/tests/sim/build_${core}_sim.sh" >&2
+
+  base_rate=$(cd "$BASE_TREE" &&
+    flavor_cycles_per_sec "tests/sim/build/${core}_sim${suffix}" "$MANIFEST")
+  new_rate=$(cd "$REPO_ROOT" &&
+    flavor_cycles_per_sec "tests/sim/build/${core}_sim${suffix}" "$MANIFEST")
+  awk -v core="$core" -v base="$base_rate" -v new="$new_rate" -v rev="$base_label" 'BEGIN {
+    printf "%s: %d cycles/s vs %d cycles/s at %s", core, new, base, rev
+    if (base > 0) printf " (%.2fx)", new / base
+    printf "\n"
+  }'
+done
@@ -0,0 +1,71 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Builds a bus-level MemPort target: the MemPort top for <bus> wrapped by
+# memport_main.h with the matching slave model from bus_slave.h.
+#
+# Usage: build_memport_sim.sh <tlul|axi4lite|ahblite>
+#
+#   tlul      ZeroNyteMemPort        TL-UL master
+#   axi4lite  TetraNyteTLToAXI4Lite  TL-UL -> AXI4-Lite bridge
+#   ahblite   TetraNyteTLToAHBLite   TL-UL -> AXI4-Lite -> AHB-Lite bridges
+#
+# SIM_FLAVOR applies as for the core simulators (see sim_build.sh).
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+REPO_ROOT=$(cd "$SCRIPT_DIR/../.." && pwd)
+
+if [[ $# -ne 1 ]]; then
+  echo "Usage: $(basename "$0") <tlul|axi4lite|ahblite>" >&2
+  exit 1
+fi
+BUS="$1"
+case "$BUS" in
+  tlul) TOP=ZeroNyteMemPort ;;
+  axi4lite) TOP=TetraNyteTLToAXI4Lite ;;
+  ahblite) TOP=TetraNyteTLToAHBLite ;;
+  *)
+    echo "Unknown bus '$BUS' (expected tlul, axi4lite or ahblite)" >&2
+    exit 1
+    ;;
+esac
+
+cd "$REPO_ROOT"
+
+SIM_DIR="tests/sim"
+BUILD_DIR="$SIM_DIR/build"
+OBJ_DIR="$BUILD_DIR/obj_dir_memport_$BUS"
+
+source "$SCRIPT_DIR/sim_build.sh"
+flavor_init "memport_$BUS"
+
+mkdir -p "$BUILD_DIR"
+
+VERILOG_TOP="rtl/generators/generated/verilog_hierarchical_timed/$TOP.v"
+if [[ ! -f "$VERILOG_TOP" ]]; then
+  echo "Expected RTL at $VERILOG_TOP. Regenerate with 'sbt generateRTL' from rtl/." >&2
+  exit 1
+fi
+
+verilate_model() {
+  local obj_dir="$1"
+  local cflags="$2"
+  local ldflags="$3"
+  shift 3
+  verilate_cached "$obj_dir" "V$TOP" "$cflags" "$ldflags" "$SIM_DIR/memport_${BUS}_sim.cpp" \
+    "$VERILOG_TOP" \
+    --top-module "$TOP" \
+    --timescale-override 1ns/1ns \
+    "$@"
+}
+
+if [[ "$SIM_FLAVOR" == "pgo" ]]; then
+  echo "SIM_FLAVOR=pgo is not supported for MemPort targets; use fast" >&2
+  exit 1
+fi
+flavor_build verilate_model "V$TOP"
+
+cp "$OBJ_DIR/V$TOP" "$BUILD_DIR/$SIM_NAME"
+chmod +x "$BUILD_DIR/$SIM_NAME"
+
+echo "Built simulator at $BUILD_DIR/$SIM_NAME"
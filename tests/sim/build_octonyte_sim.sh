@@ -10,9 +10,10 @@ SIM_DIR="tests/sim"
 BUILD_DIR="$SIM_DIR/build"
 OBJ_DIR="$BUILD_DIR/octonyte_obj"
 
+source "$SCRIPT_DIR/sim_build.sh"
+flavor_init octonyte
+
 mkdir -p "$BUILD_DIR"
-rm -rf "$OBJ_DIR"
-mkdir -p "$OBJ_DIR"
 
 VERILOG_TOP="rtl/generators/generated/verilog_hierarchical_timed/OctoNyteRV32ICore.v"
 RTL_SRC_DIRS=("rtl/OctoNyte/rv32i/src" "rtl/library/src")
@@ -36,21 +37,35 @@ if [[ ! -f "$VERILOG_TOP" ]]; then
   exit 1
 fi
 
-verilator -cc "$VERILOG_TOP" \
-  --top-module OctoNyteRV32ICore \
-  --Mdir "$OBJ_DIR" \
-  --timescale-override 1ns/1ns \
-  --trace \
-  --Wno-UNOPTFLAT \
-  --build \
-  -CFLAGS "-O2 -std=c++17" \
-  -LDFLAGS "-O2" \
-  --exe \
-    "$SIM_DIR/octonyte_sim.cpp" \
-    "$SIM_DIR/elf_loader.cpp" \
-    "$SIM_DIR/memory.cpp"
-
-cp "$OBJ_DIR/VOctoNyteRV32ICore" "$BUILD_DIR/octonyte_sim"
-chmod +x "$BUILD_DIR/octonyte_sim"
-
-echo "Built simulator at $BUILD_DIR/octonyte_sim"
+# Usage: verilate_model <obj-dir> <cflags> <ldflags> [extra verilator args...]
+verilate_model() {
+  local obj_dir="$1"
+  local cflags="$2"
+  local ldflags="$3"
+  shift 3
+  verilate_cached "$obj_dir" VOctoNyteRV32ICore "$cflags" "$ldflags" "$SIM_DIR/octonyte_sim.cpp" \
+    "$VERILOG_TOP" \
+    --top-module OctoNyteRV32ICore \
+    --timescale-override 1ns/1ns \
+    --Wno-UNOPTFLAT \
+    "$@"
+}
+
+flavor_build verilate_model VOctoNyteRV32ICore
+
+cp "$OBJ_DIR/VOctoNyteRV32ICore" "$BUILD_DIR/$SIM_NAME"
+chmod +x "$BUILD_DIR/$SIM_NAME"
+build_trace_decode
+build_coverage_merge
+
+if [[ -n "${VERILATOR_THREADS:-}" ]]; then
+  STATS_FILE="$OBJ_DIR/VOctoNyteRV32ICore__stats.txt"
+  if [[ -f "$STATS_FILE" ]]; then
+    cp "$STATS_FILE" "$BUILD_DIR/$SIM_NAME.stats.txt"
+    echo "Thread partitioning for --threads $VERILATOR_THREADS (full report: $BUILD_DIR/$SIM_NAME.stats.txt):"
+    grep -iE 'mtask|partition|thread' "$STATS_FILE" | sed 's/^/  /' || true
+  fi
+fi
+
+echo "Built simulator at $BUILD_DIR/$SIM_NAME"
+flavor_report "$BUILD_DIR/octonyte_sim"
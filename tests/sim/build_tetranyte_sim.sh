@@ -10,9 +10,10 @@ SIM_DIR="tests/sim"
 BUILD_DIR="$SIM_DIR/build"
 OBJ_DIR="$BUILD_DIR/tetranyte_obj"
 
+source "$SCRIPT_DIR/sim_build.sh"
+flavor_init tetranyte
+
 mkdir -p "$BUILD_DIR"
-rm -rf "$OBJ_DIR"
-mkdir -p "$OBJ_DIR"
 
 VERILOG_TOP="rtl/generators/generated/verilog_hierarchical_timed/TetraNyteRV32ICore.v"
 RTL_SRC_DIRS=("rtl/TetraNyte/rv32i/src" "rtl/library/src")
@@ -36,21 +37,35 @@ if [[ ! -f "$VERILOG_TOP" ]]; then
   exit 1
 fi
 
-verilator -cc "$VERILOG_TOP" \
-  --top-module TetraNyteRV32ICore \
-  --Mdir "$OBJ_DIR" \
-  --timescale-override 1ns/1ns \
-  --trace \
-  --Wno-UNOPTFLAT \
-  --build \
-  -CFLAGS "-O2 -std=c++17" \
-  -LDFLAGS "-O2" \
-  --exe \
-    "$SIM_DIR/tetranyte_sim.cpp" \
-    "$SIM_DIR/elf_loader.cpp" \
-    "$SIM_DIR/memory.cpp"
-
-cp "$OBJ_DIR/VTetraNyteRV32ICore" "$BUILD_DIR/tetranyte_sim"
-chmod +x "$BUILD_DIR/tetranyte_sim"
-
-echo "Built simulator at $BUILD_DIR/tetranyte_sim"
+# Usage: verilate_model <obj-dir> <cflags> <ldflags> [extra verilator args...]
+verilate_model() {
+  local obj_dir="$1"
+  local cflags="$2"
+  local ldflags="$3"
+  shift 3
+  verilate_cached "$obj_dir" VTetraNyteRV32ICore "$cflags" "$ldflags" "$SIM_DIR/tetranyte_sim.cpp" \
+    "$VERILOG_TOP" \
+    --top-module TetraNyteRV32ICore \
+    --timescale-override 1ns/1ns \
+    --Wno-UNOPTFLAT \
+    "$@"
+}
+
+flavor_build verilate_model VTetraNyteRV32ICore
+
+cp "$OBJ_DIR/VTetraNyteRV32ICore" "$BUILD_DIR/$SIM_NAME"
+chmod +x "$BUILD_DIR/$SIM_NAME"
+build_trace_decode
+build_coverage_merge
+
+if [[ -n "${VERILATOR_THREADS:-}" ]]; then
+  STATS_FILE="$OBJ_DIR/VTetraNyteRV32ICore__stats.txt"
+  if [[ -f "$STATS_FILE" ]]; then
+    cp "$STATS_FILE" "$BUILD_DIR/$SIM_NAME.stats.txt"
+    echo "Thread partitioning for --threads $VERILATOR_THREADS (full report: $BUILD_DIR/$SIM_NAME.stats.txt):"
+    grep -iE 'mtask|partition|thread' "$STATS_FILE" | sed 's/^/  /' || true
+  fi
+fi
+
+echo "Built simulator at $BUILD_DIR/$SIM_NAME"
+flavor_report "$BUILD_DIR/tetranyte_sim"
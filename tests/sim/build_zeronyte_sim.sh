@@ -10,9 +10,10 @@ SIM_DIR="tests/sim"
 BUILD_DIR="$SIM_DIR/build"
 OBJ_DIR="$BUILD_DIR/obj_dir"
 
+source "$SCRIPT_DIR/sim_build.sh"
+flavor_init zeronyte
+
 mkdir -p "$BUILD_DIR"
-rm -rf "$OBJ_DIR"
-mkdir -p "$OBJ_DIR"
 
 VERILOG_TOP="rtl/generators/generated/verilog_hierarchical_timed/ZeroNyteRV32ICore.v"
 if [[ ! -f "$VERILOG_TOP" ]]; then
@@ -20,20 +21,25 @@ if [[ ! -f "$VERILOG_TOP" ]]; then
   exit 1
 fi
 
-verilator -cc "$VERILOG_TOP" \
-  --top-module ZeroNyteRV32ICore \
-  --Mdir "$OBJ_DIR" \
-  --timescale-override 1ns/1ns \
-  --trace \
-  --build \
-  -CFLAGS "-O2 -std=c++17" \
-  -LDFLAGS "-O2" \
-  --exe \
-    "$SIM_DIR/zeronyte_sim.cpp" \
-    "$SIM_DIR/elf_loader.cpp" \
-    "$SIM_DIR/memory.cpp"
-
-cp "$OBJ_DIR/VZeroNyteRV32ICore" "$BUILD_DIR/zeronyte_sim"
-chmod +x "$BUILD_DIR/zeronyte_sim"
-
-echo "Built simulator at $BUILD_DIR/zeronyte_sim"
+# Usage: verilate_model <obj-dir> <cflags> <ldflags> [extra verilator args...]
+verilate_model() {
+  local obj_dir="$1"
+  local cflags="$2"
+  local ldflags="$3"
+  shift 3
+  verilate_cached "$obj_dir" VZeroNyteRV32ICore "$cflags" "$ldflags" "$SIM_DIR/zeronyte_sim.cpp" \
+    "$VERILOG_TOP" \
+    --top-module ZeroNyteRV32ICore \
+    --timescale-override 1ns/1ns \
+    "$@"
+}
+
+flavor_build verilate_model VZeroNyteRV32ICore
+
+cp "$OBJ_DIR/VZeroNyteRV32ICore" "$BUILD_DIR/$SIM_NAME"
+chmod +x "$BUILD_DIR/$SIM_NAME"
+build_trace_decode
+build_coverage_merge
+
+echo "Built simulator at $BUILD_DIR/$SIM_NAME"
+flavor_report "$BUILD_DIR/zeronyte_sim"
@@ -0,0 +1,177 @@
+#include "bus_slave.h"
+
+#include <stdexcept>
+
+namespace {
+
+// TL-UL opcodes (TileLink/TileLinkUL.scala).
+constexpr uint8_t kTlGet = 4;
+constexpr uint8_t kTlAccessAck = 0;
+constexpr uint8_t kTlAccessAckData = 1;
+
+// AHB-Lite transfers with bit 1 of htrans set (NONSEQ, SEQ) move data.
+constexpr uint8_t kAhbActive = 0x2;
+
+// Byte lanes of an AHB-Lite transfer of 2^hsize bytes at `addr`.
+uint32_t ahbLanes(uint32_t addr, uint8_t hsize) {
+  switch (hsize) {
+    case 0:
+      return 0x1u << (addr & 0x3u);
+    case 1:
+      return 0x3u << (addr & 0x2u);
+    default:
+      return 0xFu;
+  }
+}
+
+}  // namespace
+
+void validateBusTiming(const BusTiming& timing) {
+  if (timing.backpressure.find_first_not_of("01") != std::string::npos) {
+    throw std::invalid_argument("backpressure pattern must contain only '0' and '1'");
+  }
+  if (!timing.backpressure.empty() && timing.backpressure.find('1') == std::string::npos) {
+    throw std::invalid_argument("backpressure pattern never accepts a request");
+  }
+  if (timing.max_outstanding == 0) {
+    throw std::invalid_argument("max outstanding requests must be at least 1");
+  }
+}
+
+BusSlave::BusSlave(Memory& memory, const BusTiming& timing) : memory_(memory), timing_(timing) {}
+
+bool BusSlave::read(uint32_t addr, uint32_t& data) {
+  const uint32_t word = addr & ~0x3u;
+  if (word - memory_.base() >= memory_.size()) {
+    data = 0;
+    ++stats_.errors;
+    return false;
+  }
+  data = memory_.read32(word);
+  ++stats_.reads;
+  return true;
+}
+
+bool BusSlave::write(uint32_t addr, uint32_t data, uint32_t mask) {
+  const uint32_t word = addr & ~0x3u;
+  if (word - memory_.base() >= memory_.size()) {
+    ++stats_.errors;
+    return false;
+  }
+  memory_.writeMasked(word, data, mask);
+  ++stats_.writes;
+  return true;
+}
+
+void TlUlSlave::drive(TlUlPins& pins) const {
+  pins.a_ready = patternReady() && responses_.size() < timing_.max_outstanding;
+  pins.d_valid = !responses_.empty() && responses_.front().ready_at <= cycle_;
+  if (pins.d_valid) {
+    const Response& response = responses_.front();
+    pins.d_opcode = response.opcode;
+    pins.d_size = response.size;
+    pins.d_source = response.source;
+    pins.d_denied = response.denied;
+    pins.d_data = response.data;
+  }
+}
+
+void TlUlSlave::edge(const TlUlPins& pins) {
+  if (pins.d_valid && pins.d_ready) {
+    responses_.pop_front();
+  }
+  if (pins.a_valid && pins.a_ready) {
+    Response response{respondAt(), kTlAccessAck, pins.a_size, pins.a_source, false, 0};
+    if (pins.a_opcode == kTlGet) {
+      response.opcode = kTlAccessAckData;
+      response.denied = !read(pins.a_address, response.data);
+    } else {
+      response.denied = !write(pins.a_address, pins.a_data, pins.a_mask);
+    }
+    responses_.push_back(response);
+    noteInFlight(responses_.size());
+  } else if (pins.a_valid) {
+    ++stats_.stall_cycles;
+  }
+  ++cycle_;
+}
+
+void Axi4LiteSlave::drive(Axi4LitePins& pins) const {
+  const bool ready = patternReady();
+  pins.aw_ready = ready && aw_.size() + b_.size() < timing_.max_outstanding;
+  pins.w_ready = ready && w_.size() + b_.size() < timing_.max_outstanding;
+  pins.ar_ready = ready && r_.size() < timing_.max_outstanding;
+
+  pins.b_valid = !b_.empty() && b_.front().ready_at <= cycle_;
+  pins.b_resp = pins.b_valid ? b_.front().resp : kOkay;
+  pins.r_valid = !r_.empty() && r_.front().ready_at <= cycle_;
+  if (pins.r_valid) {
+    pins.r_data = r_.front().data;
+    pins.r_resp = r_.front().resp;
+  }
+}
+
+void Axi4LiteSlave::edge(const Axi4LitePins& pins) {
+  if (pins.b_valid && pins.b_ready) {
+    b_.pop_front();
+  }
+  if (pins.r_valid && pins.r_ready) {
+    r_.pop_front();
+  }
+
+  if (pins.aw_valid && pins.aw_ready) {
+    aw_.push_back(pins.aw_addr);
+  }
+  if (pins.w_valid && pins.w_ready) {
+    w_.push_back({pins.w_data, pins.w_strb});
+  }
+  while (!aw_.empty() && !w_.empty()) {
+    const bool ok = write(aw_.front(), w_.front().data, w_.front().strb);
+    b_.push_back({respondAt(), 0, ok ? kOkay : kSlvErr});
+    aw_.pop_front();
+    w_.pop_front();
+  }
+
+  if (pins.ar_valid && pins.ar_ready) {
+    Response response{respondAt(), 0, kOkay};
+    response.resp = read(pins.ar_addr, response.data) ? kOkay : kSlvErr;
+    r_.push_back(response);
+  }
+
+  if ((pins.aw_valid && !pins.aw_ready) || (pins.w_valid && !pins.w_ready) ||
+      (pins.ar_valid && !pins.ar_ready)) {
+    ++stats_.stall_cycles;
+  }
+  noteInFlight(aw_.size() + b_.size() + r_.size());
+  ++cycle_;
+}
+
+void AhbLiteSlave::drive(AhbLitePins& pins) const {
+  pins.hready = patternReady() && (timing_.wait_states == 0 || (waiting_ && remaining_ == 0));
+  pins.hrdata = hrdata_;
+  pins.hresp = hresp_;
+}
+
+void AhbLiteSlave::edge(const AhbLitePins& pins) {
+  if (pins.hsel && (pins.htrans & kAhbActive) != 0) {
+    if (pins.hready) {
+      waiting_ = false;
+      if (pins.hwrite) {
+        hresp_ = !write(pins.haddr, pins.hwdata, ahbLanes(pins.haddr, pins.hsize));
+      } else {
+        hresp_ = !read(pins.haddr, hrdata_);
+      }
+      noteInFlight(1);
+    } else {
+      if (!waiting_) {
+        waiting_ = true;
+        remaining_ = timing_.wait_states;
+      }
+      if (remaining_ > 0) {
+        --remaining_;
+      }
+      ++stats_.stall_cycles;
+    }
+  }
+  ++cycle_;
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#include "memory.h"
+
+// Transaction-level slave models for the MemPort bus masters (TL-UL,
+// AXI4-Lite, AHB-Lite), backed by a Memory. Each cycle the harness calls
+//   drive(pins)  before eval, to set the slave's outputs from its state, and
+//   edge(pins)   after the low-phase eval, with the master's outputs settled,
+//                to take the handshakes that fire on the rising edge.
+// Slave outputs depend only on state, so one eval per phase settles the bus.
+
+// Timing shared by the three models.
+struct BusTiming {
+  // Cycles between accepting a request and presenting its response; AHB-Lite
+  // instead holds hready low this many cycles before taking a transfer.
+  unsigned wait_states = 0;
+  // Ready pattern, one '1' or '0' per cycle, repeated; empty = always ready.
+  std::string backpressure;
+  // Requests accepted but not yet answered. AHB-Lite is always 1.
+  unsigned max_outstanding = 1;
+};
+
+// Throws std::invalid_argument unless the pattern is '0'/'1' characters with
+// at least one '1', and max_outstanding is at least 1.
+void validateBusTiming(const BusTiming& timing);
+
+struct BusStats {
+  uint64_t reads = 0;
+  uint64_t writes = 0;
+  uint64_t errors = 0;         // accesses outside the memory window
+  uint64_t stall_cycles = 0;   // a request was offered but not taken
+  uint64_t max_in_flight = 0;  // most requests outstanding at once
+};
+
+// Bookkeeping common to the three models.
+class BusSlave {
+ public:
+  const BusStats& stats() const { return stats_; }
+
+ protected:
+  BusSlave(Memory& memory, const BusTiming& timing);
+
+  // Backpressure allows taking a request this cycle.
+  bool patternReady() const {
+    return timing_.backpressure.empty() ||
+           timing_.backpressure[cycle_ % timing_.backpressure.size()] == '1';
+  }
+  uint64_t respondAt() const { return cycle_ + 1 + timing_.wait_states; }
+
+  // Word access at `addr & ~3`. Both return false, leaving memory untouched
+  // (and `data` zero), when the word lies outside the memory window.
+  bool read(uint32_t addr, uint32_t& data);
+  bool write(uint32_t addr, uint32_t data, uint32_t mask);
+
+  void noteInFlight(uint64_t count) {
+    if (count > stats_.max_in_flight) {
+      stats_.max_in_flight = count;
+    }
+  }
+
+  Memory& memory_;
+  BusTiming timing_;
+  uint64_t cycle_ = 0;
+  BusStats stats_;
+};
+
+// TileLink-UL slave. Requests are answered in order; Get returns the whole
+// word, PutFullData/PutPartialData write the lanes in a_mask. Out-of-window
+// accesses are answered with d_denied.
+struct TlUlPins {
+  bool a_valid = false;
+  bool a_ready = false;  // slave
+  uint8_t a_opcode = 0;
+  uint8_t a_size = 0;
+  uint8_t a_source = 0;
+  uint8_t a_mask = 0;
+  uint32_t a_address = 0;
+  uint32_t a_data = 0;
+
+  bool d_valid = false;  // slave
+  bool d_ready = false;
+  uint8_t d_opcode = 0;  // slave, as are the rest
+  uint8_t d_size = 0;
+  uint8_t d_source = 0;
+  bool d_denied = false;
+  uint32_t d_data = 0;
+};
+
+class TlUlSlave : public BusSlave {
+ public:
+  using Pins = TlUlPins;
+
+  TlUlSlave(Memory& memory, const BusTiming& timing) : BusSlave(memory, timing) {}
+
+  void drive(TlUlPins& pins) const;
+  void edge(const TlUlPins& pins);
+
+ private:
+  struct Response {
+    uint64_t ready_at;
+    uint8_t opcode;
+    uint8_t size;
+    uint8_t source;
+    bool denied;
+    uint32_t data;
+  };
+
+  std::deque<Response> responses_;
+};
+
+// AXI4-Lite slave. AW and W are taken independently and paired in order;
+// writes and reads each keep up to max_outstanding transactions in flight.
+// Out-of-window accesses answer SLVERR.
+struct Axi4LitePins {
+  bool aw_valid = false;
+  bool aw_ready = false;  // slave
+  uint32_t aw_addr = 0;
+
+  bool w_valid = false;
+  bool w_ready = false;  // slave
+  uint32_t w_data = 0;
+  uint8_t w_strb = 0;
+
+  bool b_valid = false;  // slave
+  bool b_ready = false;
+  uint8_t b_resp = 0;  // slave
+
+  bool ar_valid = false;
+  bool ar_ready = false;  // slave
+  uint32_t ar_addr = 0;
+
+  bool r_valid = false;  // slave
+  bool r_ready = false;
+  uint32_t r_data = 0;  // slave
+  uint8_t r_resp = 0;   // slave
+};
+
+class Axi4LiteSlave : public BusSlave {
+ public:
+  using Pins = Axi4LitePins;
+
+  static constexpr uint8_t kOkay = 0;
+  static constexpr uint8_t kSlvErr = 2;
+
+  Axi4LiteSlave(Memory& memory, const BusTiming& timing) : BusSlave(memory, timing) {}
+
+  void drive(Axi4LitePins& pins) const;
+  void edge(const Axi4LitePins& pins);
+
+ private:
+  struct Response {
+    uint64_t ready_at;
+    uint32_t data;
+    uint8_t resp;
+  };
+  struct WriteData {
+    uint32_t data;
+    uint8_t strb;
+  };
+
+  std::deque<uint32_t> aw_;
+  std::deque<WriteData> w_;
+  std::deque<Response> b_;
+  std::deque<Response> r_;
+};
+
+// AHB-Lite slave, following the library's convention (AHBLiteRAM and the
+// AXI4LiteToAHBLite bridge): hwdata accompanies the address phase, and read
+// data appears on hrdata the cycle after the transfer is taken and holds
+// until the next read. Wait states hold hready low before a transfer is
+// taken, since the bridge samples hrdata without waiting for hready.
+// Out-of-window accesses raise hresp alongside hready.
+struct AhbLitePins {
+  uint32_t haddr = 0;
+  bool hwrite = false;
+  uint8_t htrans = 0;
+  uint8_t hsize = 0;
+  bool hsel = false;
+  uint32_t hwdata = 0;
+
+  uint32_t hrdata = 0;  // slave
+  bool hready = false;  // slave
+  bool hresp = false;   // slave
+};
+
+class AhbLiteSlave : public BusSlave {
+ public:
+  using Pins = AhbLitePins;
+
+  AhbLiteSlave(Memory& memory, const BusTiming& timing) : BusSlave(memory, timing) {}
+
+  void drive(AhbLitePins& pins) const;
+  void edge(const AhbLitePins& pins);
+
+ private:
+  bool waiting_ = false;  // a transfer is being held by wait states
+  unsigned remaining_ = 0;
+  uint32_t hrdata_ = 0;
+  bool hresp_ = false;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "elf_loader.h"
+#include "memory.h"
+
+#if NYTE_SAVABLE
+#include "verilated_save.h"
+#endif
+
+// Whole-simulation snapshots for --checkpoint-at / --restore. A checkpoint is
+// one VerilatedSave stream holding, in order: a CheckpointHeader, the test's
+// ElfSymbols, the harness's own state block (thread PCs, fetch bookkeeping,
+// tohost status), every allocated Memory page and finally the Verilated model
+// itself, which requires the model to be verilated with --savable. The header
+// records the thread mask, which a restore must match. --mmio device state
+// and host files the guest opened through HTIF are not saved, so the harness
+// refuses --restore with --mmio and checkpoints while such files are open.
+//
+// This header is compiled as part of each harness main rather than the shared
+// harness library because it needs the Verilator runtime headers. The build
+// scripts define NYTE_SAVABLE for models verilated with --savable; without it
+// both entry points throw.
+
+struct CheckpointHeader {
+  char magic[8];
+  char core[16];
+  uint32_t state_size;
+  uint32_t page_size;
+  uint32_t thread_mask;
+  uint64_t cycle;
+  uint64_t page_count;
+};
+
+namespace checkpoint_detail {
+
+constexpr char kMagic[8] = {'N', 'Y', 'T', 'E', 'C', 'K', 'P', '2'};
+
+inline CheckpointHeader makeHeader(const char* core, uint32_t state_size, uint32_t thread_mask,
+                                   uint64_t cycle, uint64_t page_count) {
+  CheckpointHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  std::strncpy(header.core, core, sizeof(header.core) - 1);
+  header.state_size = state_size;
+  header.page_size = Memory::kPageSize;
+  header.thread_mask = thread_mask;
+  header.cycle = cycle;
+  header.page_count = page_count;
+  return header;
+}
+
+}  // namespace checkpoint_detail
+
+// Writes a checkpoint taken after `cycle` post-reset cycles of a run with
+// `thread_mask` enabled. `State` is the harness's plain-data state block.
+// Throws std::runtime_error if the file cannot be created.
+template <typename Model, typename State>
+void saveCheckpoint(const std::string& path, const char* core, uint64_t cycle,
+                    uint32_t thread_mask, const ElfSymbols& symbols, const State& state,
+                    const Memory& memory, Model& model) {
+  static_assert(std::is_trivially_copyable<State>::value, "harness state must be plain data");
+#if NYTE_SAVABLE
+  uint64_t page_count = 0;
+  memory.forEachPage([&](uint32_t, const uint8_t*) { ++page_count; });
+
+  VerilatedSave os;
+  os.open(path.c_str());
+  if (!os.isOpen()) {
+    throw std::runtime_error("cannot create checkpoint " + path);
+  }
+  const CheckpointHeader header =
+      checkpoint_detail::makeHeader(core, sizeof(State), thread_mask, cycle, page_count);
+  os.write(&header, sizeof(header));
+  os.write(&symbols, sizeof(symbols));
+  os.write(&state, sizeof(state));
+  memory.forEachPage([&](uint32_t addr, const uint8_t* data) {
+    os.write(&addr, sizeof(addr));
+    os.write(data, Memory::kPageSize);
+  });
+  os << model;
+  os.close();
+#else
+  (void)path, (void)core, (void)cycle, (void)thread_mask, (void)symbols, (void)state,
+      (void)memory, (void)model;
+  throw std::runtime_error("simulator was verilated without --savable");
+#endif
+}
+
+// Restores a checkpoint written by saveCheckpoint for the same core and
+// harness build into a cleared `memory` and `model`. Returns the cycle the
+// checkpoint was taken at. Throws std::runtime_error on a missing file, a
+// header that does not match this harness or a different `thread_mask`;
+// Verilator itself aborts if the model part was saved from a different model.
+template <typename Model, typename State>
+uint64_t restoreCheckpoint(const std::string& path, const char* core, uint32_t thread_mask,
+                           ElfSymbols& symbols, State& state, Memory& memory, Model& model) {
+  static_assert(std::is_trivially_copyable<State>::value, "harness state must be plain data");
+#if NYTE_SAVABLE
+  VerilatedRestore is;
+  is.open(path.c_str());
+  if (!is.isOpen()) {
+    throw std::runtime_error("cannot open checkpoint " + path);
+  }
+  CheckpointHeader header{};
+  is.read(&header, sizeof(header));
+  const CheckpointHeader expected =
+      checkpoint_detail::makeHeader(core, sizeof(State), thread_mask, 0, 0);
+  if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+      std::memcmp(header.core, expected.core, sizeof(header.core)) != 0 ||
+      header.state_size != expected.state_size || header.page_size != expected.page_size) {
+    throw std::runtime_error(path + " is not a checkpoint for " + core + " from this harness");
+  }
+  if (header.thread_mask != thread_mask) {
+    char masks[64];
+    std::snprintf(masks, sizeof(masks), "--thread-mask 0x%x, not 0x%x", header.thread_mask,
+                  thread_mask);
+    throw std::runtime_error(path + " was taken with " + masks);
+  }
+  is.read(&symbols, sizeof(symbols));
+  is.read(&state, sizeof(state));
+
+  memory.clear();
+  std::vector<uint8_t> page(Memory::kPageSize);
+  for (uint64_t i = 0; i < header.page_count; ++i) {
+    uint32_t addr = 0;
+    is.read(&addr, sizeof(addr));
+    is.read(page.data(), page.size());
+    memory.writeBlock(addr, page.data(), Memory::kPageSize);
+  }
+  is >> model;
+  is.close();
+  return header.cycle;
+#else
+  (void)path, (void)core, (void)thread_mask, (void)symbols, (void)state, (void)memory, (void)model;
+  throw std::runtime_error("simulator was verilated without --savable");
+#endif
+}
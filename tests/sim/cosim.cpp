@@ -0,0 +1,66 @@
+#include "cosim.h"
+
+#include <cstdio>
+
+namespace {
+
+std::string hex(uint32_t value) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "0x%08x", value);
+  return buf;
+}
+
+std::string describeWrite(uint32_t rd, uint32_t value) {
+  return rd == 0 ? "no register write" : "x" + std::to_string(rd) + "=" + hex(value);
+}
+
+}  // namespace
+
+Cosim::Cosim(uint32_t mem_base, uint32_t mem_size, unsigned num_threads)
+    : memory_(mem_base, mem_size), num_threads_(num_threads) {}
+
+void Cosim::reset(const Memory& image, uint32_t reset_pc) {
+  memory_.clear();
+  image.forEachPage([&](uint32_t addr, const uint8_t* data) {
+    memory_.writeBlock(addr, data, Memory::kPageSize);
+  });
+  harts_.clear();
+  harts_.reserve(num_threads_);
+  for (unsigned t = 0; t < num_threads_; ++t) {
+    harts_.emplace_back(memory_, reset_pc);
+  }
+  mismatch_.clear();
+}
+
+bool Cosim::retire(uint64_t cycle, const RetireEvent& event) {
+  IssHart& hart = harts_.at(event.thread);
+  auto where = [&] {
+    return "cycle " + std::to_string(cycle) + " thread " + std::to_string(event.thread) + ": ";
+  };
+
+  if (event.pc != hart.pc()) {
+    mismatch_ = where() + "retired pc " + hex(event.pc) + ", reference expected pc " + hex(hart.pc());
+    return false;
+  }
+
+  const IssRetire expected = hart.step();
+  if (event.instr != expected.instr) {
+    mismatch_ = where() + "pc " + hex(event.pc) + " retired instr " + hex(event.instr) +
+                ", reference fetched " + hex(expected.instr);
+    return false;
+  }
+
+  if (expected.csr) {
+    // The reference has no CSRs, so it adopts whatever the core read.
+    hart.setReg(event.rd, event.data);
+    return true;
+  }
+
+  if (event.rd != expected.rd || (event.rd != 0 && event.data != expected.rd_value)) {
+    mismatch_ = where() + "pc " + hex(event.pc) + " instr " + hex(event.instr) + " wrote " +
+                describeWrite(event.rd, event.data) + ", reference wrote " +
+                describeWrite(expected.rd, expected.rd_value);
+    return false;
+  }
+  return true;
+}
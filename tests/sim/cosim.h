@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "iss.h"
+#include "memory.h"
+
+// One instruction retired by the DUT, as reported by a harness.
+struct RetireEvent {
+  unsigned thread = 0;
+  uint32_t pc = 0;
+  uint32_t instr = 0;
+  uint32_t rd = 0;  // register written, 0 for none
+  uint32_t data = 0;
+};
+
+// Lockstep checker for --cosim. Holds a private copy of the test image and one
+// reference hart per hardware thread; every retirement the harness reports
+// steps that thread's hart once and is compared against it. Threads share the
+// reference memory and update it in retirement order, so programs whose
+// threads race on memory can diverge spuriously. CSR instructions (csrr of
+// cycle, instret, mhartid, ...) are checked for PC and encoding only: the
+// register the core wrote is copied into the reference hart unchecked.
+class Cosim {
+ public:
+  Cosim(uint32_t mem_base, uint32_t mem_size, unsigned num_threads);
+
+  // Copies the freshly loaded test image into the reference memory and resets
+  // every hart to `reset_pc`. Call before the DUT starts writing `image`.
+  void reset(const Memory& image, uint32_t reset_pc);
+
+  // Checks one DUT retirement observed at `cycle`. Returns false at the first
+  // PC, instruction or register-write mismatch; mismatch() then describes it.
+  bool retire(uint64_t cycle, const RetireEvent& event);
+
+  const std::string& mismatch() const { return mismatch_; }
+
+  // The reference memory, for host-side writes the DUT's memory also
+  // receives (the HTIF syscall proxy's replies).
+  Memory& memory() { return memory_; }
+
+ private:
+  Memory memory_;
+  unsigned num_threads_;
+  std::vector<IssHart> harts_;
+  std::string mismatch_;
+};
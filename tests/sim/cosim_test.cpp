@@ -0,0 +1,96 @@
+// Self-test for the --cosim checker and its reference ISS; needs no Verilator.
+// Built and run by run_harness_tests.sh. Exits nonzero on the first failure.
+
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+
+#include "cosim.h"
+#include "memory.h"
+
+namespace {
+
+constexpr uint32_t kBase = 0x80000000u;
+
+// Encodings used below.
+constexpr uint32_t kCsrrA0Mhartid = 0xf1402573;  // csrr a0, mhartid
+constexpr uint32_t kCsrrA1Cycle = 0xc00025f3;    // csrr a1, cycle
+constexpr uint32_t kAddiA2A1One = 0x00158613;    // addi a2, a1, 1
+constexpr uint32_t kAddiA2A0One = 0x00150613;    // addi a2, a0, 1
+constexpr uint32_t kEcall = 0x00000073;
+
+int failures = 0;
+
+void check(bool ok, const char* what, const Cosim& cosim) {
+  if (!ok) {
+    std::cerr << "FAIL: " << what;
+    if (!cosim.mismatch().empty()) {
+      std::cerr << " (" << cosim.mismatch() << ")";
+    }
+    std::cerr << std::endl;
+    ++failures;
+  }
+}
+
+// A Cosim reset to a program of `instrs` at kBase. Heap-allocated since its
+// harts refer to its memory.
+std::unique_ptr<Cosim> program(std::initializer_list<uint32_t> instrs) {
+  Memory image(kBase, 1u << 16);
+  uint32_t addr = kBase;
+  for (const uint32_t instr : instrs) {
+    image.write32(addr, instr);
+    addr += 4;
+  }
+  auto cosim = std::make_unique<Cosim>(kBase, 1u << 16, 1);
+  cosim->reset(image, kBase);
+  return cosim;
+}
+
+bool retire(Cosim& cosim, uint32_t index, uint32_t instr, uint32_t rd, uint32_t data) {
+  RetireEvent event;
+  event.pc = kBase + 4 * index;
+  event.instr = instr;
+  event.rd = rd;
+  event.data = data;
+  return cosim.retire(index, event);
+}
+
+void csrReadsAreTakenFromTheCore() {
+  const auto program_cosim = program({kCsrrA0Mhartid, kCsrrA1Cycle, kAddiA2A1One, kEcall});
+  Cosim& cosim = *program_cosim;
+  check(retire(cosim, 0, kCsrrA0Mhartid, 10, 0), "csrr mhartid", cosim);
+  check(retire(cosim, 1, kCsrrA1Cycle, 11, 1234), "csrr cycle", cosim);
+  check(retire(cosim, 2, kAddiA2A1One, 12, 1235), "addi after csrr cycle", cosim);
+  check(retire(cosim, 3, kEcall, 0, 0), "ecall", cosim);
+}
+
+void csrWithoutRegisterWrite() {
+  // The current cores implement no CSRs and retire csrr without writing rd.
+  const auto program_cosim = program({kCsrrA0Mhartid, kAddiA2A0One});
+  Cosim& cosim = *program_cosim;
+  check(retire(cosim, 0, kCsrrA0Mhartid, 0, 0), "csrr with no write", cosim);
+  check(retire(cosim, 1, kAddiA2A0One, 12, 1), "addi after csrr with no write", cosim);
+}
+
+void otherMismatchesAreStillCaught() {
+  const auto program_cosim = program({kCsrrA1Cycle, kAddiA2A1One});
+  Cosim& cosim = *program_cosim;
+  check(retire(cosim, 0, kCsrrA1Cycle, 11, 7), "csrr cycle", cosim);
+  check(!retire(cosim, 1, kAddiA2A1One, 12, 9), "wrong addi result is reported", cosim);
+}
+
+}  // namespace
+
+int main() {
+  csrReadsAreTakenFromTheCore();
+  csrWithoutRegisterWrite();
+  otherMismatchesAreStillCaught();
+  if (failures != 0) {
+    std::cerr << failures << " cosim check(s) failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "cosim_test: all checks passed" << std::endl;
+  return EXIT_SUCCESS;
+}
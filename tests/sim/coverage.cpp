@@ -0,0 +1,137 @@
+#include "coverage.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'Y', 'T', 'E', 'C', 'O', 'V', '1'};
+constexpr size_t kCoreNameBytes = 16;
+
+template <typename T>
+void put(std::ostream& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T get(std::istream& in, const std::string& path) {
+  T value{};
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+    throw std::runtime_error(path + ": truncated coverage file");
+  }
+  return value;
+}
+
+// Writes the non-zero entries of `values` as (u32 index, u64 value) pairs.
+void putSparse(std::ostream& out, const std::vector<uint64_t>& values) {
+  uint32_t count = 0;
+  for (uint64_t value : values) {
+    count += value != 0;
+  }
+  put(out, count);
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (values[i] != 0) {
+      put(out, static_cast<uint32_t>(i));
+      put(out, values[i]);
+    }
+  }
+}
+
+void getSparse(std::istream& in, const std::string& path, std::vector<uint64_t>& values) {
+  const uint32_t count = get<uint32_t>(in, path);
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint32_t index = get<uint32_t>(in, path);
+    const uint64_t value = get<uint64_t>(in, path);
+    if (index >= values.size()) {
+      throw std::runtime_error(path + ": coverage index out of range");
+    }
+    values[index] = value;
+  }
+}
+
+}  // namespace
+
+Coverage::Coverage(const std::string& core, unsigned num_threads, uint32_t mem_base,
+                   uint32_t mem_size)
+    : core_(core), mem_base_(mem_base), mem_size_(mem_size), threads_(num_threads) {
+  const size_t bitmap_words = (static_cast<size_t>(mem_size) / 4 + 63) / 64;
+  for (Thread& thread : threads_) {
+    thread.pcs.assign(bitmap_words, 0);
+    thread.opcodes.assign(kOpcodeKeys, 0);
+  }
+}
+
+void Coverage::merge(const Coverage& other) {
+  if (other.core_ != core_ || other.threads_.size() != threads_.size() ||
+      other.mem_base_ != mem_base_ || other.mem_size_ != mem_size_) {
+    throw std::invalid_argument("coverage from " + other.core_ + " cannot merge into " + core_ +
+                                " coverage of a different shape");
+  }
+  for (size_t t = 0; t < threads_.size(); ++t) {
+    Thread& mine = threads_[t];
+    const Thread& theirs = other.threads_[t];
+    for (size_t i = 0; i < mine.pcs.size(); ++i) {
+      mine.pcs[i] |= theirs.pcs[i];
+    }
+    for (size_t i = 0; i < mine.opcodes.size(); ++i) {
+      mine.opcodes[i] += theirs.opcodes[i];
+    }
+    mine.outside += theirs.outside;
+  }
+}
+
+void Coverage::save(const std::string& path) const {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(kMagic, sizeof(kMagic));
+  char name[kCoreNameBytes] = {};
+  std::strncpy(name, core_.c_str(), sizeof(name) - 1);
+  out.write(name, sizeof(name));
+  put(out, static_cast<uint32_t>(threads_.size()));
+  put(out, mem_base_);
+  put(out, mem_size_);
+  for (const Thread& thread : threads_) {
+    put(out, thread.outside);
+    putSparse(out, thread.pcs);
+    putSparse(out, thread.opcodes);
+  }
+  if (!out) {
+    throw std::runtime_error("failed to write coverage file " + path);
+  }
+}
+
+Coverage Coverage::load(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  char magic[sizeof(kMagic)] = {};
+  char name[kCoreNameBytes] = {};
+  if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !in.read(name, sizeof(name))) {
+    throw std::runtime_error(path + " is not a coverage file");
+  }
+  name[sizeof(name) - 1] = '\0';
+  const uint32_t num_threads = get<uint32_t>(in, path);
+  const uint32_t mem_base = get<uint32_t>(in, path);
+  const uint32_t mem_size = get<uint32_t>(in, path);
+  if (num_threads == 0 || num_threads > 32) {
+    throw std::runtime_error(path + ": bad thread count");
+  }
+
+  Coverage coverage(name, num_threads, mem_base, mem_size);
+  for (Thread& thread : coverage.threads_) {
+    thread.outside = get<uint64_t>(in, path);
+    getSparse(in, path, thread.pcs);
+    getSparse(in, path, thread.opcodes);
+  }
+  return coverage;
+}
+
+uint64_t Coverage::coveredPcs(unsigned thread) const {
+  uint64_t covered = 0;
+  for (uint64_t word : threads_[thread].pcs) {
+    covered += static_cast<uint64_t>(__builtin_popcountll(word));
+  }
+  return covered;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Guest coverage for --coverage, gathered from the retire stream. Per
+// hardware thread it keeps a dense bitmap of retired instruction addresses,
+// bit (pc - mem_base) >> 2 over the memory window, and a histogram of retired
+// opcode/funct3 pairs. Coverage files merge by OR-ing bitmaps and adding
+// histograms; coverage_merge does that offline.
+//
+// File format (little-endian): the magic "NYTECOV1", the core name in 16
+// bytes, then num_threads, mem_base and mem_size as u32. Each thread follows
+// as u64 retired-outside-window, then u32 n and n pairs of (u32 bitmap word
+// index, u64 word) for the non-zero bitmap words, then u32 m and m pairs of
+// (u32 key, u64 count) for the non-zero histogram entries.
+class Coverage {
+ public:
+  // Histogram key: opcode in bits 6:0, funct3 in bits 9:7.
+  static constexpr unsigned kOpcodeKeys = 1024;
+
+  Coverage(const std::string& core, unsigned num_threads, uint32_t mem_base, uint32_t mem_size);
+
+  static unsigned opcodeKey(uint32_t instr) { return (instr & 0x7f) | ((instr >> 5) & 0x380); }
+
+  void retire(unsigned thread, uint32_t pc, uint32_t instr) {
+    Thread& t = threads_[thread];
+    const uint32_t index = (pc - mem_base_) >> 2;
+    if (pc - mem_base_ < mem_size_) {
+      t.pcs[index >> 6] |= uint64_t{1} << (index & 63);
+    } else {
+      ++t.outside;
+    }
+    ++t.opcodes[opcodeKey(instr)];
+  }
+
+  // Adds `other`'s coverage. Throws std::invalid_argument unless both were
+  // recorded for the same core and memory window.
+  void merge(const Coverage& other);
+
+  // Throws std::runtime_error on I/O failure or a malformed file.
+  void save(const std::string& path) const;
+  static Coverage load(const std::string& path);
+
+  const std::string& core() const { return core_; }
+  unsigned numThreads() const { return static_cast<unsigned>(threads_.size()); }
+  uint32_t memBase() const { return mem_base_; }
+  uint32_t memSize() const { return mem_size_; }
+
+  // Per-thread views for reports.
+  uint64_t coveredPcs(unsigned thread) const;
+  uint64_t outside(unsigned thread) const { return threads_[thread].outside; }
+  const std::vector<uint64_t>& pcBitmap(unsigned thread) const { return threads_[thread].pcs; }
+  const std::vector<uint64_t>& opcodeCounts(unsigned thread) const {
+    return threads_[thread].opcodes;
+  }
+
+ private:
+  struct Thread {
+    std::vector<uint64_t> pcs;      // one bit per instruction word
+    std::vector<uint64_t> opcodes;  // kOpcodeKeys counts
+    uint64_t outside = 0;           // retired outside the memory window
+  };
+
+  std::string core_;
+  uint32_t mem_base_;
+  uint32_t mem_size_;
+  std::vector<Thread> threads_;
+};
@@ -0,0 +1,156 @@
+// Merges --coverage files and reports on them:
+//   coverage_merge [-o merged.cov] [--report] [--rank] <in.cov>...
+// --report prints per-thread covered instruction words and the retired
+// opcode/funct3 histogram of the merge. --rank orders the inputs greedily by
+// the coverage points (instruction words per thread, opcode/funct3 pairs per
+// thread) each adds to those already picked, and lists the inputs that add
+// none as redundant.
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "coverage.h"
+
+namespace {
+
+const char* kBranch[8] = {"beq", "bne", "?", "?", "blt", "bge", "bltu", "bgeu"};
+const char* kLoad[8] = {"lb", "lh", "lw", "?", "lbu", "lhu", "?", "?"};
+const char* kStore[8] = {"sb", "sh", "sw", "?", "?", "?", "?", "?"};
+const char* kOpImm[8] = {"addi", "slli", "slti", "sltiu", "xori", "srli/srai", "ori", "andi"};
+const char* kOp[8] = {"add/sub", "sll", "slt", "sltu", "xor", "srl/sra", "or", "and"};
+
+std::string mnemonic(unsigned key) {
+  const unsigned opcode = key & 0x7f;
+  const unsigned funct3 = key >> 7;
+  switch (opcode) {
+    case 0x37: return "lui";
+    case 0x17: return "auipc";
+    case 0x6f: return "jal";
+    case 0x67: return "jalr";
+    case 0x63: return kBranch[funct3];
+    case 0x03: return kLoad[funct3];
+    case 0x23: return kStore[funct3];
+    case 0x13: return kOpImm[funct3];
+    case 0x33: return kOp[funct3];
+    case 0x0f: return "fence";
+    case 0x73: return funct3 == 0 ? "ecall/ebreak" : "csr";
+    default: return "?";
+  }
+}
+
+// Points of `coverage` not yet in `seen`.
+uint64_t newPoints(const Coverage& coverage, const Coverage& seen) {
+  uint64_t points = 0;
+  for (unsigned t = 0; t < coverage.numThreads(); ++t) {
+    const std::vector<uint64_t>& pcs = coverage.pcBitmap(t);
+    const std::vector<uint64_t>& seen_pcs = seen.pcBitmap(t);
+    for (size_t i = 0; i < pcs.size(); ++i) {
+      points += static_cast<uint64_t>(__builtin_popcountll(pcs[i] & ~seen_pcs[i]));
+    }
+    const std::vector<uint64_t>& opcodes = coverage.opcodeCounts(t);
+    const std::vector<uint64_t>& seen_opcodes = seen.opcodeCounts(t);
+    for (size_t i = 0; i < opcodes.size(); ++i) {
+      points += opcodes[i] != 0 && seen_opcodes[i] == 0;
+    }
+  }
+  return points;
+}
+
+void report(const Coverage& coverage) {
+  std::printf("core %s, %u thread(s)\n", coverage.core().c_str(), coverage.numThreads());
+  for (unsigned t = 0; t < coverage.numThreads(); ++t) {
+    std::printf("thread %u: %" PRIu64 " instruction words covered, %" PRIu64
+                " retired outside memory\n",
+                t, coverage.coveredPcs(t), coverage.outside(t));
+    const std::vector<uint64_t>& opcodes = coverage.opcodeCounts(t);
+    for (unsigned key = 0; key < opcodes.size(); ++key) {
+      if (opcodes[key] != 0) {
+        std::printf("  opcode 0x%02x funct3 %u %-12s %" PRIu64 "\n", key & 0x7f, key >> 7,
+                    mnemonic(key).c_str(), opcodes[key]);
+      }
+    }
+  }
+}
+
+void rank(const std::vector<std::string>& paths, const std::vector<Coverage>& inputs) {
+  const Coverage& first = inputs.front();
+  Coverage seen(first.core(), first.numThreads(), first.memBase(), first.memSize());
+  std::vector<bool> picked(inputs.size(), false);
+  for (;;) {
+    size_t best = inputs.size();
+    uint64_t best_points = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (!picked[i]) {
+        const uint64_t points = newPoints(inputs[i], seen);
+        if (points > best_points) {
+          best = i;
+          best_points = points;
+        }
+      }
+    }
+    if (best == inputs.size()) {
+      break;
+    }
+    picked[best] = true;
+    seen.merge(inputs[best]);
+    std::printf("keep %s +%" PRIu64 "\n", paths[best].c_str(), best_points);
+  }
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (!picked[i]) {
+      std::printf("redundant %s\n", paths[i].c_str());
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string output;
+  bool want_report = false;
+  bool want_rank = false;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "-o" && i + 1 < argc) {
+      output = argv[++i];
+    } else if (arg == "--report") {
+      want_report = true;
+    } else if (arg == "--rank") {
+      want_rank = true;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.empty()) {
+    std::cerr << "usage: " << argv[0] << " [-o merged.cov] [--report] [--rank] <in.cov>..."
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    std::vector<Coverage> inputs;
+    for (const std::string& path : paths) {
+      inputs.push_back(Coverage::load(path));
+    }
+    Coverage merged = inputs.front();
+    for (size_t i = 1; i < inputs.size(); ++i) {
+      merged.merge(inputs[i]);
+    }
+    if (!output.empty()) {
+      merged.save(output);
+    }
+    if (want_report) {
+      report(merged);
+    }
+    if (want_rank) {
+      rank(paths, inputs);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Coverage merge failed: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
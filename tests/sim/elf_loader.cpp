@@ -1,8 +1,19 @@
 #include "elf_loader.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
-#include <fstream>
+#include <iostream>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -65,33 +76,81 @@ struct Elf32_Sym {
 enum : uint32_t {
   PT_LOAD = 1,
   SHT_SYMTAB = 2,
+  SHF_EXECINSTR = 0x4,
+  STT_NOTYPE = 0,
+  STT_FUNC = 2,
+  STB_GLOBAL = 1,
+  SHN_LORESERVE = 0xff00,
 };
 
-std::vector<uint8_t> readFile(const std::string& path) {
-  std::ifstream file(path, std::ios::binary);
-  if (!file.is_open()) {
-    throw std::runtime_error("failed to open ELF: " + path);
+// Read-only private mapping of a whole file. Replaces slurping the ELF
+// through an istreambuf_iterator; the loader only touches the pages it copies.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+  }
+
+  bool open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+      ::close(fd);
+      return false;
+    }
+    void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      return false;
+    }
+    data_ = static_cast<const uint8_t*>(addr);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
   }
-  std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-  return buffer;
-}
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
 
 template <typename T>
-T readStruct(const std::vector<uint8_t>& data, uint32_t offset) {
-  if (offset + sizeof(T) > data.size()) {
+T readStruct(const uint8_t* data, size_t size, uint64_t offset) {
+  if (offset + sizeof(T) > size) {
     throw std::runtime_error("ELF parse error: truncated file");
   }
   T value{};
-  std::memcpy(&value, data.data() + offset, sizeof(T));
+  std::memcpy(&value, data + offset, sizeof(T));
   return value;
 }
 
-}  // namespace
+// A loadable range: `filesz` bytes copied from `offset` in the source buffer,
+// then zero fill up to `memsz`.
+struct ImageSegment {
+  uint32_t addr;
+  uint32_t filesz;
+  uint32_t memsz;
+  uint32_t offset;
+};
 
-void loadElfIntoMemory(const std::string& path, Memory& memory, ElfSymbols& symbols) {
-  const auto image = readFile(path);
-  const Elf32_Ehdr ehdr = readStruct<Elf32_Ehdr>(image, 0);
+struct ParsedImage {
+  ElfSymbols symbols;
+  uint32_t entry = 0;
+  std::vector<ImageSegment> segments;
+};
 
+Elf32_Ehdr readHeader(const uint8_t* data, size_t size) {
+  const Elf32_Ehdr ehdr = readStruct<Elf32_Ehdr>(data, size, 0);
   if (ehdr.e_ident[0] != kElfMagic0 || ehdr.e_ident[1] != kElfMagic1 ||
       ehdr.e_ident[2] != kElfMagic2 || ehdr.e_ident[3] != kElfMagic3) {
     throw std::runtime_error("invalid ELF magic");
@@ -99,60 +158,375 @@ void loadElfIntoMemory(const std::string& path, Memory& memory, ElfSymbols& symb
   if (ehdr.e_ident[4] != 1 || ehdr.e_ident[5] != 1) {
     throw std::runtime_error("unsupported ELF format");
   }
+  return ehdr;
+}
+
+Elf32_Shdr readSection(const uint8_t* data, size_t size, const Elf32_Ehdr& ehdr, uint32_t index) {
+  return readStruct<Elf32_Shdr>(data, size,
+                                ehdr.e_shoff + static_cast<uint64_t>(index) * ehdr.e_shentsize);
+}
+
+// The symbol table and the bounds of its string table.
+class SymbolTable {
+ public:
+  SymbolTable(const uint8_t* data, size_t size, const Elf32_Ehdr& ehdr) : data_(data), size_(size) {
+    symtab_ = [&]() -> Elf32_Shdr {
+      for (uint16_t i = 0; i < ehdr.e_shnum; ++i) {
+        const Elf32_Shdr shdr = readSection(data, size, ehdr, i);
+        if (shdr.sh_type == SHT_SYMTAB) {
+          return shdr;
+        }
+      }
+      throw std::runtime_error("ELF missing symbol table");
+    }();
+    if (symtab_.sh_entsize == 0) {
+      throw std::runtime_error("ELF symbol table has zero entry size");
+    }
+    const Elf32_Shdr strtab = readSection(data, size, ehdr, symtab_.sh_link);
+    strtab_begin_ = strtab.sh_offset;
+    strtab_end_ =
+        std::min<uint64_t>(static_cast<uint64_t>(strtab.sh_offset) + strtab.sh_size, size);
+  }
+
+  uint32_t count() const { return symtab_.sh_size / symtab_.sh_entsize; }
+
+  Elf32_Sym symbol(uint32_t idx) const {
+    return readStruct<Elf32_Sym>(
+        data_, size_, symtab_.sh_offset + static_cast<uint64_t>(idx) * symtab_.sh_entsize);
+  }
+
+  // The symbol's name; empty if it has none or it lies outside the table.
+  std::string_view name(const Elf32_Sym& sym) const {
+    const uint64_t name_off = strtab_begin_ + sym.st_name;
+    if (sym.st_name == 0 || name_off >= strtab_end_) {
+      return {};
+    }
+    const char* raw = reinterpret_cast<const char*>(data_ + name_off);
+    return std::string_view(raw, ::strnlen(raw, strtab_end_ - name_off));
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  Elf32_Shdr symtab_;
+  uint64_t strtab_begin_ = 0;
+  uint64_t strtab_end_ = 0;
+};
+
+ParsedImage parseElf(const uint8_t* data, size_t size) {
+  ParsedImage parsed;
+  const Elf32_Ehdr ehdr = readHeader(data, size);
+  parsed.entry = ehdr.e_entry;
 
   for (uint16_t i = 0; i < ehdr.e_phnum; ++i) {
-    const uint32_t offset = ehdr.e_phoff + i * ehdr.e_phentsize;
-    const Elf32_Phdr phdr = readStruct<Elf32_Phdr>(image, offset);
+    const uint64_t offset = ehdr.e_phoff + static_cast<uint64_t>(i) * ehdr.e_phentsize;
+    const Elf32_Phdr phdr = readStruct<Elf32_Phdr>(data, size, offset);
     if (phdr.p_type != PT_LOAD) {
       continue;
     }
-    for (uint32_t byte = 0; byte < phdr.p_filesz; ++byte) {
-      const uint32_t src_index = phdr.p_offset + byte;
-      if (src_index >= image.size()) {
-        throw std::runtime_error("ELF segment exceeds file size");
-      }
-      memory.write8(phdr.p_paddr + byte, image[src_index]);
+    if (static_cast<uint64_t>(phdr.p_offset) + phdr.p_filesz > size) {
+      throw std::runtime_error("ELF segment exceeds file size");
     }
-    for (uint32_t byte = phdr.p_filesz; byte < phdr.p_memsz; ++byte) {
-      memory.write8(phdr.p_paddr + byte, 0);
+    if (phdr.p_filesz > phdr.p_memsz) {
+      throw std::runtime_error("ELF segment file size exceeds memory size");
     }
+    parsed.segments.push_back({phdr.p_paddr, phdr.p_filesz, phdr.p_memsz, phdr.p_offset});
   }
 
-  const Elf32_Shdr shdr_symtab = [&]() -> Elf32_Shdr {
-    for (uint16_t i = 0; i < ehdr.e_shnum; ++i) {
-      const uint32_t off = ehdr.e_shoff + i * ehdr.e_shentsize;
-      const Elf32_Shdr shdr = readStruct<Elf32_Shdr>(image, off);
-      if (shdr.sh_type == SHT_SYMTAB) {
-        return shdr;
-      }
-    }
-    throw std::runtime_error("ELF missing symbol table");
-  }();
-
-  const Elf32_Shdr shdr_strtab = readStruct<Elf32_Shdr>(image, ehdr.e_shoff + shdr_symtab.sh_link * ehdr.e_shentsize);
-  const uint32_t sym_count = shdr_symtab.sh_size / shdr_symtab.sh_entsize;
+  const SymbolTable table(data, size, ehdr);
+  const uint32_t sym_count = table.count();
 
-  for (uint32_t idx = 0; idx < sym_count; ++idx) {
-    const uint32_t sym_off = shdr_symtab.sh_offset + idx * shdr_symtab.sh_entsize;
-    const Elf32_Sym sym = readStruct<Elf32_Sym>(image, sym_off);
-    const uint32_t name_off = shdr_strtab.sh_offset + sym.st_name;
-    if (name_off >= image.size()) {
+  ElfSymbols& symbols = parsed.symbols;
+  enum : unsigned { kToHost = 1, kFromHost = 2, kBeginSig = 4, kEndSig = 8, kAll = 15 };
+  unsigned found = 0;
+  for (uint32_t idx = 0; idx < sym_count && found != kAll; ++idx) {
+    const Elf32_Sym sym = table.symbol(idx);
+    const std::string_view name = table.name(sym);
+    if (name.empty()) {
       continue;
     }
-
-    const char* name = reinterpret_cast<const char*>(image.data() + name_off);
-    if (std::strcmp(name, "tohost") == 0) {
+    if (name == "tohost") {
       symbols.tohost = sym.st_value;
-    } else if (std::strcmp(name, "fromhost") == 0) {
+      found |= kToHost;
+    } else if (name == "fromhost") {
       symbols.fromhost = sym.st_value;
-    } else if (std::strcmp(name, "begin_signature") == 0) {
+      found |= kFromHost;
+    } else if (name == "begin_signature") {
       symbols.begin_signature = sym.st_value;
-    } else if (std::strcmp(name, "end_signature") == 0) {
+      found |= kBeginSig;
+    } else if (name == "end_signature") {
       symbols.end_signature = sym.st_value;
+      found |= kEndSig;
     }
   }
 
   if (symbols.tohost == 0 || symbols.begin_signature == 0 || symbols.end_signature == 0) {
     throw std::runtime_error("required ELF symbols missing");
   }
+  return parsed;
+}
+
+void applySegments(const uint8_t* data, const std::vector<ImageSegment>& segments, Memory& memory,
+                   ElfLayout& layout) {
+  layout.low = UINT32_MAX;
+  layout.high = 0;
+  for (const ImageSegment& seg : segments) {
+    memory.writeBlock(seg.addr, data + seg.offset, seg.filesz);
+    memory.fill(seg.addr + seg.filesz, 0, seg.memsz - seg.filesz);
+    layout.low = std::min(layout.low, seg.addr);
+    layout.high = std::max(layout.high, seg.addr + seg.memsz);
+  }
+  if (segments.empty()) {
+    layout.low = 0;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Preprocessed image cache
+//
+// <cache_dir>/<fnv1a64 of ELF>.img holds a CacheHeader, `segment_count`
+// ImageSegment records whose offsets point into the same file, then the raw
+// segment bytes. Files are written to a temporary name and renamed so
+// concurrent simulators never observe a partial image.
+// ---------------------------------------------------------------------------
+
+constexpr char kCacheMagic[8] = {'N', 'Y', 'T', 'E', 'I', 'M', 'G', '\0'};
+constexpr uint32_t kCacheVersion = 2;
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t segment_count;
+  uint64_t elf_hash;
+  uint64_t elf_size;
+  ElfSymbols symbols;
+  uint32_t entry;
+};
+
+uint64_t hashBytes(const uint8_t* data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+std::string cachePath(const std::string& cache_dir, uint64_t hash) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.img", static_cast<unsigned long long>(hash));
+  return cache_dir + "/" + name;
+}
+
+bool loadCachedImage(const std::string& path, uint64_t hash, uint64_t elf_size,
+                     Memory& memory, ElfSymbols& symbols, ElfLayout& layout) {
+  MappedFile cached;
+  if (!cached.open(path) || cached.size() < sizeof(CacheHeader)) {
+    return false;
+  }
+  // Any malformed file is a miss, not an error: the caller reparses the ELF
+  // and rewrites the cache. Everything is bounds-checked before it is read.
+  CacheHeader header;
+  std::memcpy(&header, cached.data(), sizeof(header));
+  if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      header.version != kCacheVersion || header.elf_hash != hash || header.elf_size != elf_size ||
+      header.symbols.tohost == 0 || header.symbols.begin_signature == 0 ||
+      header.symbols.end_signature == 0) {
+    return false;
+  }
+  const uint64_t table_end =
+      sizeof(CacheHeader) + static_cast<uint64_t>(header.segment_count) * sizeof(ImageSegment);
+  if (table_end > cached.size()) {
+    return false;
+  }
+
+  std::vector<ImageSegment> segments(header.segment_count);
+  const uint8_t* table = cached.data() + sizeof(CacheHeader);
+  for (uint32_t i = 0; i < header.segment_count; ++i) {
+    ImageSegment& seg = segments[i];
+    std::memcpy(&seg, table + i * sizeof(ImageSegment), sizeof(seg));
+    if (seg.offset < table_end || static_cast<uint64_t>(seg.offset) + seg.filesz > cached.size() ||
+        seg.filesz > seg.memsz) {
+      return false;
+    }
+  }
+
+  applySegments(cached.data(), segments, memory, layout);
+  symbols = header.symbols;
+  layout.entry = header.entry;
+  return true;
+}
+
+void storeCachedImage(const std::string& cache_dir, const std::string& path, uint64_t hash,
+                      uint64_t elf_size, const uint8_t* elf_data, const ParsedImage& parsed) {
+  if (::mkdir(cache_dir.c_str(), 0775) != 0 && errno != EEXIST) {
+    std::cerr << "Warning: cannot create ELF image cache " << cache_dir << std::endl;
+    return;
+  }
+
+  CacheHeader header{};
+  std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.segment_count = static_cast<uint32_t>(parsed.segments.size());
+  header.elf_hash = hash;
+  header.elf_size = elf_size;
+  header.symbols = parsed.symbols;
+  header.entry = parsed.entry;
+
+  std::vector<ImageSegment> segments = parsed.segments;
+  uint32_t data_offset = static_cast<uint32_t>(sizeof(CacheHeader) + segments.size() * sizeof(ImageSegment));
+  for (ImageSegment& seg : segments) {
+    seg.offset = data_offset;
+    data_offset += seg.filesz;
+  }
+
+  // mkstemp names the file uniquely, so batch workers caching the same ELF
+  // at once each write their own file and the last rename wins.
+  std::string tmp = path + ".tmp.XXXXXX";
+  const int fd = ::mkstemp(&tmp[0]);
+  if (fd < 0) {
+    std::cerr << "Warning: cannot create ELF image cache file in " << cache_dir << std::endl;
+    return;
+  }
+  ::fchmod(fd, 0664);
+  FILE* out = ::fdopen(fd, "wb");
+  if (out == nullptr) {
+    ::close(fd);
+    std::remove(tmp.c_str());
+    return;
+  }
+  std::fwrite(&header, sizeof(header), 1, out);
+  std::fwrite(segments.data(), sizeof(ImageSegment), segments.size(), out);
+  for (const ImageSegment& seg : parsed.segments) {
+    std::fwrite(elf_data + seg.offset, 1, seg.filesz, out);
+  }
+  const bool written = std::ferror(out) == 0;
+  if (std::fclose(out) != 0 || !written) {
+    std::cerr << "Warning: failed to write ELF image cache " << tmp << std::endl;
+    std::remove(tmp.c_str());
+    return;
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+  }
+}
+
+}  // namespace
+
+void loadElfIntoMemory(const std::string& path, Memory& memory, ElfSymbols& symbols) {
+  loadElfIntoMemory(path, memory, symbols, std::string());
+}
+
+void loadElfIntoMemory(const std::string& path, Memory& memory, ElfSymbols& symbols,
+                       const std::string& cache_dir) {
+  ElfLayout layout;
+  loadElfIntoMemory(path, memory, symbols, cache_dir, layout);
+}
+
+void loadElfIntoMemory(const std::string& path, Memory& memory, ElfSymbols& symbols,
+                       const std::string& cache_dir, ElfLayout& layout) {
+  MappedFile elf;
+  if (!elf.open(path)) {
+    throw std::runtime_error("failed to open ELF: " + path);
+  }
+
+  if (cache_dir.empty()) {
+    const ParsedImage parsed = parseElf(elf.data(), elf.size());
+    applySegments(elf.data(), parsed.segments, memory, layout);
+    symbols = parsed.symbols;
+    layout.entry = parsed.entry;
+    return;
+  }
+
+  const uint64_t hash = hashBytes(elf.data(), elf.size());
+  const std::string cached = cachePath(cache_dir, hash);
+  if (loadCachedImage(cached, hash, elf.size(), memory, symbols, layout)) {
+    return;
+  }
+
+  const ParsedImage parsed = parseElf(elf.data(), elf.size());
+  applySegments(elf.data(), parsed.segments, memory, layout);
+  symbols = parsed.symbols;
+  layout.entry = parsed.entry;
+  storeCachedImage(cache_dir, cached, hash, elf.size(), elf.data(), parsed);
+}
+
+void ElfSymbolIndex::add(const ElfSymbolIndex& other) {
+  functions_.insert(functions_.end(), other.functions_.begin(), other.functions_.end());
+  std::sort(functions_.begin(), functions_.end(),
+            [](const ElfFunction& a, const ElfFunction& b) { return a.addr < b.addr; });
+}
+
+const ElfFunction* ElfSymbolIndex::find(uint32_t pc) const {
+  auto it = std::upper_bound(functions_.begin(), functions_.end(), pc,
+                             [](uint32_t addr, const ElfFunction& f) { return addr < f.addr; });
+  if (it == functions_.begin()) {
+    return nullptr;
+  }
+  --it;
+  return pc - it->addr < it->size ? &*it : nullptr;
+}
+
+ElfSymbolIndex loadElfSymbolIndex(const std::string& path) {
+  MappedFile elf;
+  if (!elf.open(path)) {
+    throw std::runtime_error("failed to open ELF: " + path);
+  }
+  const uint8_t* data = elf.data();
+  const size_t size = elf.size();
+  const Elf32_Ehdr ehdr = readHeader(data, size);
+  const SymbolTable table(data, size, ehdr);
+
+  struct Candidate {
+    ElfFunction function;
+    uint32_t section_end;
+    int rank;  // higher wins among symbols at the same address
+  };
+  std::vector<Candidate> candidates;
+  for (uint32_t idx = 0; idx < table.count(); ++idx) {
+    const Elf32_Sym sym = table.symbol(idx);
+    const unsigned type = sym.st_info & 0xf;
+    if ((type != STT_FUNC && type != STT_NOTYPE) || sym.st_shndx == 0 ||
+        sym.st_shndx >= SHN_LORESERVE || sym.st_shndx >= ehdr.e_shnum) {
+      continue;
+    }
+    const std::string_view name = table.name(sym);
+    if (name.empty() || name[0] == '$' || name.rfind(".L", 0) == 0) {
+      continue;
+    }
+    const Elf32_Shdr section = readSection(data, size, ehdr, sym.st_shndx);
+    if (!(section.sh_flags & SHF_EXECINSTR)) {
+      continue;
+    }
+    const int rank = (type == STT_FUNC ? 2 : 0) + ((sym.st_info >> 4) == STB_GLOBAL ? 1 : 0);
+    candidates.push_back(
+        {{sym.st_value, sym.st_size, std::string(name)}, section.sh_addr + section.sh_size, rank});
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+    return a.function.addr != b.function.addr ? a.function.addr < b.function.addr
+                                              : a.rank > b.rank;
+  });
+
+  ElfSymbolIndex index;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const Candidate& c = candidates[i];
+    if (i > 0 && candidates[i - 1].function.addr == c.function.addr) {
+      continue;
+    }
+    uint32_t end = c.section_end;
+    for (size_t j = i + 1; j < candidates.size(); ++j) {
+      if (candidates[j].function.addr != c.function.addr) {
+        end = std::min(end, candidates[j].function.addr);
+        break;
+      }
+    }
+    ElfFunction function = c.function;
+    if (function.size == 0 || function.size > end - function.addr) {
+      function.size = end - function.addr;
+    }
+    if (function.size != 0) {
+      index.functions_.push_back(std::move(function));
+    }
+  }
+  return index;
 }
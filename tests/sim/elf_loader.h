@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "memory.h"
 
@@ -12,4 +13,55 @@ struct ElfSymbols {
   uint32_t end_signature = 0;
 };
 
+// Where an ELF image lands: its entry point and the span of its loadable
+// segments, [low, high).
+struct ElfLayout {
+  uint32_t entry = 0;
+  uint32_t low = 0;
+  uint32_t high = 0;
+};
+
 void loadElfIntoMemory(const std::string& path, Memory& memory, ElfSymbols& symbols);
+
+// Same as above, but consults a directory of preprocessed images keyed by a
+// hash of the ELF contents. A hit restores the loadable segments and symbols
+// from one mmap'd file; a miss parses the ELF and writes the image for next
+// time. An empty `cache_dir` disables the cache.
+void loadElfIntoMemory(const std::string& path, Memory& memory, ElfSymbols& symbols,
+                       const std::string& cache_dir);
+
+// Same again, also reporting the image's layout.
+void loadElfIntoMemory(const std::string& path, Memory& memory, ElfSymbols& symbols,
+                       const std::string& cache_dir, ElfLayout& layout);
+
+// A code symbol covering [addr, addr + size).
+struct ElfFunction {
+  uint32_t addr = 0;
+  uint32_t size = 0;
+  std::string name;
+};
+
+// Code symbols sorted by address with non-overlapping ranges, for mapping
+// PCs back to functions. Function (STT_FUNC) and untyped label symbols in
+// executable sections are indexed; a symbol without a size extends to the
+// next one or the end of its section. Local labels (.L*) and RISC-V mapping
+// symbols ($x, $d) are skipped.
+class ElfSymbolIndex {
+ public:
+  // Adds another image's functions, e.g. one per --thread-elf program.
+  void add(const ElfSymbolIndex& other);
+
+  // The function containing `pc`, or nullptr.
+  const ElfFunction* find(uint32_t pc) const;
+
+  const std::vector<ElfFunction>& functions() const { return functions_; }
+
+ private:
+  friend ElfSymbolIndex loadElfSymbolIndex(const std::string& path);
+
+  std::vector<ElfFunction> functions_;
+};
+
+// Builds the index from the full symbol table of the ELF at `path`. Throws
+// std::runtime_error if it cannot be read or parsed.
+ElfSymbolIndex loadElfSymbolIndex(const std::string& path);
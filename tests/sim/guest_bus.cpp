@@ -0,0 +1,191 @@
+#include "guest_bus.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+std::string hex(uint32_t value) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "0x%08x", value);
+  return buf;
+}
+
+bool overlaps(uint32_t a_base, uint32_t a_size, uint32_t b_base, uint32_t b_size) {
+  return a_base - b_base < b_size || b_base - a_base < a_size;
+}
+
+uint32_t low(uint64_t value) { return static_cast<uint32_t>(value); }
+uint32_t high(uint64_t value) { return static_cast<uint32_t>(value >> 32); }
+
+// Replaces the byte lanes of `value` selected by `mask` with those of `data`.
+uint32_t merge(uint32_t value, uint32_t data, uint32_t mask) {
+  uint32_t lanes = 0;
+  for (int i = 0; i < 4; ++i) {
+    lanes |= ((mask >> i) & 0x1u) ? 0xFFu << (8 * i) : 0;
+  }
+  return (value & ~lanes) | (data & lanes);
+}
+
+class Uart : public MmioDevice {
+ public:
+  explicit Uart(GuestConsole& console) : console_(console) {}
+
+  const char* name() const override { return "uart"; }
+
+  uint32_t read(uint32_t offset) override {
+    constexpr uint32_t kLsrEmpty = 0x60;  // THRE | TEMT, in byte lane 1 of word 4
+    return offset == 4 ? kLsrEmpty << 8 : 0;
+  }
+
+  void write(uint32_t offset, uint32_t data, uint32_t mask) override {
+    if (offset == 0 && (mask & 0x1u)) {
+      const char c = static_cast<char>(data & 0xFFu);
+      console_.write(&c, 1);
+    }
+  }
+
+ private:
+  GuestConsole& console_;
+};
+
+class Clint : public MmioDevice {
+ public:
+  static constexpr uint32_t kMtimecmp = 0x4000;
+  static constexpr uint32_t kMtime = 0xbff8;
+
+  Clint(unsigned num_threads, const uint64_t& cycles)
+      : cycles_(cycles), mtimecmp_(2 * num_threads, 0xFFFFFFFFu) {}
+
+  const char* name() const override { return "clint"; }
+
+  uint32_t read(uint32_t offset) override {
+    if (offset == kMtime || offset == kMtime + 4) {
+      return offset == kMtime ? low(cycles_) : high(cycles_);
+    }
+    const uint32_t index = (offset - kMtimecmp) / 4;
+    return offset >= kMtimecmp && index < mtimecmp_.size() ? mtimecmp_[index] : 0;
+  }
+
+  void write(uint32_t offset, uint32_t data, uint32_t mask) override {
+    const uint32_t index = (offset - kMtimecmp) / 4;
+    if (offset >= kMtimecmp && index < mtimecmp_.size()) {
+      mtimecmp_[index] = merge(mtimecmp_[index], data, mask);
+      return;
+    }
+    if (offset < kMtimecmp) {
+      return;  // msip: no software interrupts to raise
+    }
+    throw std::runtime_error("clint offset " + hex(offset) + " is read-only or unmapped");
+  }
+
+ private:
+  const uint64_t& cycles_;
+  std::vector<uint32_t> mtimecmp_;  // low, high per hart
+};
+
+class Counters : public MmioDevice {
+ public:
+  Counters(const uint64_t& cycles, const RunStats& stats) : cycles_(cycles), stats_(stats) {}
+
+  const char* name() const override { return "counters"; }
+
+  uint32_t read(uint32_t offset) override {
+    uint64_t instret = 0;
+    if (offset >= 8) {
+      for (const ThreadStats& thread : stats_.threads) {
+        instret += thread.retired;
+      }
+    }
+    switch (offset) {
+      case 0: return low(cycles_);
+      case 4: return high(cycles_);
+      case 8: return low(instret);
+      case 12: return high(instret);
+      default: return 0;
+    }
+  }
+
+  void write(uint32_t, uint32_t, uint32_t) override {
+    throw std::runtime_error("the counters are read-only");
+  }
+
+ private:
+  const uint64_t& cycles_;
+  const RunStats& stats_;
+};
+
+}  // namespace
+
+void GuestConsole::write(const char* data, size_t size) {
+  if (discard_) {
+    return;
+  }
+  std::ostream* out = &std::cout;
+  if (!path_.empty()) {
+    if (!file_.is_open()) {
+      file_.open(path_, std::ios::trunc);
+      if (!file_) {
+        throw std::runtime_error("cannot create " + path_);
+      }
+    }
+    out = &file_;
+  }
+  out->write(data, static_cast<std::streamsize>(size));
+  if (std::find(data, data + size, '\n') != data + size) {
+    out->flush();
+  }
+}
+
+void GuestBus::map(uint32_t base, uint32_t size, std::unique_ptr<MmioDevice> device) {
+  if (overlaps(base, size, ram_base_, ram_size_)) {
+    throw std::invalid_argument(std::string(device->name()) + " at " + hex(base) +
+                                " overlaps RAM");
+  }
+  for (const Region& region : regions_) {
+    if (overlaps(base, size, region.base, region.size)) {
+      throw std::invalid_argument(std::string(device->name()) + " at " + hex(base) +
+                                  " overlaps " + region.device->name());
+    }
+  }
+  regions_.push_back({base, size, std::move(device)});
+}
+
+const GuestBus::Region* GuestBus::find(uint32_t addr) const {
+  for (const Region& region : regions_) {
+    if (addr - region.base < region.size) {
+      return &region;
+    }
+  }
+  return nullptr;
+}
+
+uint32_t GuestBus::readOther(uint32_t addr) {
+  if (const Region* region = find(addr)) {
+    return region->device->read((addr - region->base) & ~0x3u);
+  }
+  return ram_.read32(addr);  // loader-placed pages, or zero
+}
+
+bool GuestBus::storeOther(uint32_t addr, uint32_t data, uint32_t mask) {
+  if (const Region* region = find(addr)) {
+    region->device->write((addr - region->base) & ~0x3u, data, mask);
+    return false;
+  }
+  if (!ram_.strayMapped(addr)) {
+    throw std::runtime_error("store to unmapped address " + hex(addr));
+  }
+  ram_.writeMasked(addr, data, mask);
+  return true;
+}
+
+void mapStandardDevices(GuestBus& bus, unsigned num_threads, const uint64_t& cycles,
+                        const RunStats& stats, GuestConsole& console) {
+  bus.map(kClintBase, kClintSize, std::make_unique<Clint>(num_threads, cycles));
+  bus.map(kUartBase, kUartSize, std::make_unique<Uart>(console));
+  bus.map(kCounterBase, kCounterSize, std::make_unique<Counters>(cycles, stats));
+}
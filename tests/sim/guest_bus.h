@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memory.h"
+#include "stats.h"
+
+// Where guest console output (the UART, HTIF writes to fds 1 and 2) goes:
+// stdout, or a file created on the first byte so quiet tests leave none.
+class GuestConsole {
+ public:
+  GuestConsole() = default;
+  explicit GuestConsole(std::string path) : path_(std::move(path)) {}
+
+  // A console that drops everything written to it.
+  static GuestConsole discarding() {
+    GuestConsole console;
+    console.discard_ = true;
+    return console;
+  }
+
+  // Flushes at each newline. Throws std::runtime_error if the file cannot
+  // be created.
+  void write(const char* data, size_t size);
+
+ private:
+  std::string path_;
+  std::ofstream file_;
+  bool discard_ = false;
+};
+
+// A memory-mapped device. Offsets are word aligned and relative to the
+// device's base; stores carry byte-lane enables like Memory::writeMasked.
+class MmioDevice {
+ public:
+  virtual ~MmioDevice() = default;
+  virtual const char* name() const = 0;
+  virtual uint32_t read(uint32_t offset) = 0;
+  // Throws std::runtime_error for a store the device does not accept.
+  virtual void write(uint32_t offset, uint32_t data, uint32_t mask) = 0;
+};
+
+// The address space the cores' load/store and fetch ports see: the RAM window
+// of a Memory, decoded with a single range check, and a small table of
+// devices searched only for addresses outside it. Pages a loader placed
+// outside the window (ELF segments, boot stubs) stay readable and writable.
+// A store anywhere else throws instead of allocating memory behind the
+// guest's back; a load from an unmapped address returns zero.
+class GuestBus {
+ public:
+  explicit GuestBus(Memory& ram) : ram_(ram), ram_base_(ram.base()), ram_size_(ram.size()) {}
+
+  // Throws std::invalid_argument if [base, base + size) overlaps the RAM
+  // window or another device.
+  void map(uint32_t base, uint32_t size, std::unique_ptr<MmioDevice> device);
+
+  bool isRam(uint32_t addr) const { return addr - ram_base_ < ram_size_; }
+  Memory& ram() { return ram_; }
+
+  uint32_t read32(uint32_t addr) { return isRam(addr) ? ram_.read32(addr) : readOther(addr); }
+
+  // Returns true if the store went to memory, false if to a device. Throws
+  // std::runtime_error for a store to an unmapped address or one a device
+  // rejects.
+  bool store(uint32_t addr, uint32_t data, uint32_t mask) {
+    if (isRam(addr)) {
+      ram_.writeMasked(addr, data, mask);
+      return true;
+    }
+    return storeOther(addr, data, mask);
+  }
+
+ private:
+  struct Region {
+    uint32_t base;
+    uint32_t size;
+    std::unique_ptr<MmioDevice> device;
+  };
+
+  const Region* find(uint32_t addr) const;
+  uint32_t readOther(uint32_t addr);
+  bool storeOther(uint32_t addr, uint32_t data, uint32_t mask);
+
+  Memory& ram_;
+  uint32_t ram_base_;
+  uint32_t ram_size_;
+  std::vector<Region> regions_;
+};
+
+// Devices mapped by --mmio.
+//
+//   kUartBase     16550-style console: a byte stored to THR (offset 0) is
+//                 written to the guest console, LSR (offset 5) always
+//                 reads transmitter-empty, other registers read zero.
+//   kClintBase    CLINT-style timer: mtime at +0xbff8 counts cycles,
+//                 mtimecmp at +0x4000 + 8 * hart is writable storage. The
+//                 cores take no interrupts, so nothing else happens.
+//   kCounterBase  read-only 64-bit counters, low word first: the cycle count
+//                 at +0 and instructions retired by all threads at +8.
+constexpr uint32_t kClintBase = 0x02000000u;
+constexpr uint32_t kClintSize = 0x10000u;
+constexpr uint32_t kUartBase = 0x10000000u;
+constexpr uint32_t kUartSize = 0x100u;
+constexpr uint32_t kCounterBase = 0x10001000u;
+constexpr uint32_t kCounterSize = 0x10u;
+
+// `cycles` and `stats` are read live: the cycle loop's post-reset cycle
+// count and the RunStats its retirements are counted into.
+void mapStandardDevices(GuestBus& bus, unsigned num_threads, const uint64_t& cycles,
+                        const RunStats& stats, GuestConsole& console);
@@ -0,0 +1,74 @@
+#include "hang.h"
+
+#include <cstdio>
+
+namespace {
+
+std::string hex(uint32_t value) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "0x%08x", value);
+  return buf;
+}
+
+}  // namespace
+
+HangDetector::HangDetector(uint64_t window, unsigned num_threads, uint32_t thread_mask,
+                           uint32_t mem_base, uint32_t mem_size)
+    : window_(window), mem_base_(mem_base), mem_size_(mem_size) {
+  for (unsigned t = 0; t < num_threads; ++t) {
+    if ((thread_mask >> t) & 0x1) {
+      threads_.push_back({t, 0, 0, 0, 0});
+    }
+  }
+}
+
+void HangDetector::start(uint64_t cycle, const uint32_t* pcs) {
+  for (Thread& thread : threads_) {
+    thread.pc = pcs[thread.index];
+    thread.changed = cycle;
+  }
+  openWindow(cycle);
+}
+
+void HangDetector::openWindow(uint64_t cycle) {
+  for (Thread& thread : threads_) {
+    thread.lo = thread.pc;
+    thread.hi = thread.pc;
+  }
+  stored_ = false;
+  next_check_ = cycle + window_;
+}
+
+bool HangDetector::check(uint64_t cycle) {
+  const std::string prefix = "cycle " + std::to_string(cycle) + ": ";
+  for (const Thread& thread : threads_) {
+    if (cycle - thread.changed >= window_) {
+      diagnosis_ = prefix + "thread " + std::to_string(thread.index) + " stuck at pc " +
+                   hex(thread.pc) + " for " + std::to_string(cycle - thread.changed) + " cycles";
+      return false;
+    }
+  }
+
+  if (!stored_ && !threads_.empty()) {
+    std::string where;
+    for (const Thread& thread : threads_) {
+      where += where.empty() ? "" : ", ";
+      where += "thread " + std::to_string(thread.index);
+      if (thread.hi - thread.lo < kLoopSpan) {
+        where += " looping in " + hex(thread.lo) + ".." + hex(thread.hi);
+      } else if (thread.pc - mem_base_ >= mem_size_) {
+        where += " running outside memory at pc " + hex(thread.pc);
+      } else {
+        where.clear();
+        break;
+      }
+    }
+    if (!where.empty()) {
+      diagnosis_ = prefix + "no stores for " + std::to_string(window_) + " cycles; " + where;
+      return false;
+    }
+  }
+
+  openWindow(cycle);
+  return true;
+}
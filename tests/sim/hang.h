@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Early hang detection for --hang-cycles. Every `window` cycles the detector
+// looks back over the cycles since its last check and reports a hang when
+//   - an enabled thread's PC has not changed for the whole window (a
+//     self-loop such as a trap handler's `j .`, or a stalled pipeline), or
+//   - nothing was stored and every enabled thread stayed within a small
+//     loop, or ran off the end of memory.
+// RVMODEL_HALT stores to tohost on each pass, which ends the run first.
+class HangDetector {
+ public:
+  // Loops span at most this many bytes of code.
+  static constexpr uint32_t kLoopSpan = 256;
+
+  HangDetector(uint64_t window, unsigned num_threads, uint32_t thread_mask, uint32_t mem_base,
+               uint32_t mem_size);
+
+  // Starts watching at `cycle` with the threads at `pcs`.
+  void start(uint64_t cycle, const uint32_t* pcs);
+
+  // Records one cycle. Returns false once a hang is detected; diagnosis()
+  // then describes it.
+  bool cycle(uint64_t cycle, const uint32_t* pcs, bool stored) {
+    stored_ |= stored;
+    for (Thread& thread : threads_) {
+      const uint32_t pc = pcs[thread.index];
+      if (pc != thread.pc) {
+        thread.pc = pc;
+        thread.changed = cycle;
+        thread.lo = pc < thread.lo ? pc : thread.lo;
+        thread.hi = pc > thread.hi ? pc : thread.hi;
+      }
+    }
+    return cycle < next_check_ || check(cycle);
+  }
+
+  const std::string& diagnosis() const { return diagnosis_; }
+
+ private:
+  struct Thread {
+    unsigned index;
+    uint32_t pc;
+    uint64_t changed;  // cycle the PC last moved
+    uint32_t lo, hi;   // PC range seen this window
+  };
+
+  bool check(uint64_t cycle);
+  void openWindow(uint64_t cycle);
+
+  uint64_t window_;
+  uint32_t mem_base_;
+  uint32_t mem_size_;
+  std::vector<Thread> threads_;  // enabled threads only
+  uint64_t next_check_ = 0;
+  bool stored_ = false;
+  std::string diagnosis_;
+};
@@ -0,0 +1,269 @@
+#include "htif.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// RISC-V Linux syscall numbers, as libgloss-htif issues them.
+constexpr uint64_t kSysOpenat = 56;
+constexpr uint64_t kSysClose = 57;
+constexpr uint64_t kSysLseek = 62;
+constexpr uint64_t kSysRead = 63;
+constexpr uint64_t kSysWrite = 64;
+constexpr uint64_t kSysFstat = 80;
+constexpr uint64_t kSysExit = 93;
+constexpr uint64_t kSysExitGroup = 94;
+constexpr uint64_t kSysOpen = 1024;
+
+constexpr int64_t kGuestAtFdcwd = -100;
+constexpr uint32_t kMagicMemSize = 8 * sizeof(uint64_t);
+constexpr uint32_t kStatSize = 128;  // libgloss's struct kernel_stat
+constexpr uint64_t kMaxTransfer = 1u << 20;  // per read/write call; the guest loops
+constexpr uint32_t kMaxPath = 4096;
+
+// Guest open flags use the Linux values, which are also the host's.
+constexpr int kOpenFlags = O_ACCMODE | O_CREAT | O_EXCL | O_TRUNC | O_APPEND;
+
+bool isConsole(int64_t fd) { return fd == 1 || fd == 2; }
+
+void put32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+void put64(uint8_t* out, uint64_t value) {
+  put32(out, static_cast<uint32_t>(value));
+  put32(out + 4, static_cast<uint32_t>(value >> 32));
+}
+
+}  // namespace
+
+Htif::Htif(Memory& memory, uint32_t tohost, uint32_t fromhost, GuestConsole& console,
+           Memory* mirror, bool host_io)
+    : memory_(memory), mirror_(mirror), tohost_(tohost), fromhost_(fromhost),
+      console_(console), host_io_(host_io) {}
+
+Htif::~Htif() {
+  for (const auto& file : files_) {
+    ::close(file.second);
+  }
+}
+
+bool Htif::store(uint32_t value) {
+  if ((value & 0x1u) != 0 || fromhost_ == 0 || !inRam(value, kMagicMemSize)) {
+    exit_value_ = value;
+    return true;
+  }
+  std::vector<uint64_t> args(8);
+  for (uint32_t i = 0; i < args.size(); ++i) {
+    args[i] = read64(value + 8 * i);
+  }
+  bool exited = false;
+  const int64_t result = syscall(args, exited);
+  if (exited) {
+    return true;
+  }
+  write64(value, static_cast<uint64_t>(result));
+  write64(tohost_, 0);
+  write64(fromhost_, 1);
+  return false;
+}
+
+int64_t Htif::syscall(const std::vector<uint64_t>& args, bool& exited) {
+  const uint64_t n = args[0];
+  const auto fd = static_cast<int64_t>(args[1]);
+  switch (n) {
+    case kSysExit:
+    case kSysExitGroup:
+      exit_value_ = static_cast<uint32_t>(args[1] << 1) | 1u;
+      exited = true;
+      return 0;
+    case kSysWrite:
+      return write(fd, static_cast<uint32_t>(args[2]), args[3]);
+    case kSysRead:
+      return read(fd, static_cast<uint32_t>(args[2]), args[3]);
+    case kSysOpenat:
+      if (fd != kGuestAtFdcwd) {
+        return -EBADF;  // paths resolve against the working directory only
+      }
+      return open(static_cast<uint32_t>(args[2]), args[3], args[4]);
+    case kSysOpen:
+      return open(static_cast<uint32_t>(args[1]), args[2], args[3]);
+    case kSysClose: {
+      const auto file = files_.find(fd);
+      if (file == files_.end()) {
+        return fd >= 0 && fd <= 2 ? 0 : -EBADF;
+      }
+      const int rc = ::close(file->second);
+      files_.erase(file);
+      return rc == 0 ? 0 : -errno;
+    }
+    case kSysLseek: {
+      const int host = hostFd(fd);
+      if (host < 0) {
+        return isConsole(fd) ? -ESPIPE : -EBADF;
+      }
+      const off_t pos = ::lseek(host, static_cast<off_t>(static_cast<int64_t>(args[2])),
+                                static_cast<int>(args[3]));
+      return pos < 0 ? -errno : pos;
+    }
+    case kSysFstat:
+      return fstat(fd, static_cast<uint32_t>(args[2]));
+    default:
+      if (std::find(warned_.begin(), warned_.end(), n) == warned_.end()) {
+        warned_.push_back(n);
+        std::cerr << "HTIF: unsupported syscall " << n << ", returning -ENOSYS" << std::endl;
+      }
+      return -ENOSYS;
+  }
+}
+
+int64_t Htif::open(uint32_t path_addr, uint64_t flags, uint64_t mode) {
+  if (!host_io_) {
+    return -EACCES;
+  }
+  std::string path;
+  for (uint32_t addr = path_addr;; ++addr) {
+    if (path.size() == kMaxPath) {
+      return -ENAMETOOLONG;
+    }
+    if (!inRam(addr, 1)) {
+      return -EFAULT;
+    }
+    const char c = static_cast<char>(memory_.read8(addr));
+    if (c == '\0') {
+      break;
+    }
+    path.push_back(c);
+  }
+  const int host = ::open(path.c_str(), static_cast<int>(flags) & kOpenFlags,
+                          static_cast<mode_t>(mode & 07777));
+  if (host < 0) {
+    return -errno;
+  }
+  int64_t fd = 3;
+  while (files_.count(fd) != 0) {
+    ++fd;
+  }
+  files_[fd] = host;
+  return fd;
+}
+
+int64_t Htif::read(int64_t fd, uint32_t buf, uint64_t len) {
+  len = std::min(len, kMaxTransfer);
+  if (!inRam(buf, len)) {
+    return -EFAULT;
+  }
+  if (!host_io_) {
+    return -EACCES;
+  }
+  const int host = hostFd(fd);
+  if (host < 0) {
+    return -EBADF;
+  }
+  std::vector<uint8_t> data(len);
+  const ssize_t got = ::read(host, data.data(), data.size());
+  if (got < 0) {
+    return -errno;
+  }
+  writeBlock(buf, data.data(), static_cast<uint32_t>(got));
+  return got;
+}
+
+int64_t Htif::write(int64_t fd, uint32_t buf, uint64_t len) {
+  len = std::min(len, kMaxTransfer);
+  if (!inRam(buf, len)) {
+    return -EFAULT;
+  }
+  std::vector<char> data(len);
+  for (uint32_t i = 0; i < len; ++i) {
+    data[i] = static_cast<char>(memory_.read8(buf + i));
+  }
+  if (isConsole(fd)) {
+    try {
+      console_.write(data.data(), data.size());
+    } catch (const std::exception&) {
+      return -EIO;
+    }
+    return static_cast<int64_t>(len);
+  }
+  const int host = hostFd(fd);
+  if (host < 0) {
+    return -EBADF;
+  }
+  const ssize_t put = ::write(host, data.data(), data.size());
+  return put < 0 ? -errno : put;
+}
+
+int64_t Htif::fstat(int64_t fd, uint32_t buf) {
+  if (!inRam(buf, kStatSize)) {
+    return -EFAULT;
+  }
+  struct stat st {};
+  if (isConsole(fd)) {
+    st.st_mode = S_IFCHR | 0620;  // a terminal, so newlib line-buffers the console
+    st.st_blksize = 1024;
+  } else {
+    const int host = hostFd(fd);
+    if (host < 0) {
+      return -EBADF;
+    }
+    if (::fstat(host, &st) != 0) {
+      return -errno;
+    }
+  }
+  uint8_t out[kStatSize] = {};
+  put64(out + 0, st.st_dev);
+  put64(out + 8, st.st_ino);
+  put32(out + 16, st.st_mode);
+  put32(out + 20, static_cast<uint32_t>(st.st_nlink));
+  put32(out + 24, st.st_uid);
+  put32(out + 28, st.st_gid);
+  put64(out + 32, st.st_rdev);
+  put64(out + 48, static_cast<uint64_t>(st.st_size));
+  put32(out + 56, static_cast<uint32_t>(st.st_blksize));
+  put64(out + 64, static_cast<uint64_t>(st.st_blocks));
+  put64(out + 72, static_cast<uint64_t>(st.st_atime));
+  put64(out + 88, static_cast<uint64_t>(st.st_mtime));
+  put64(out + 104, static_cast<uint64_t>(st.st_ctime));
+  writeBlock(buf, out, kStatSize);
+  return 0;
+}
+
+int Htif::hostFd(int64_t fd) const {
+  if (fd == 0) {
+    return STDIN_FILENO;
+  }
+  const auto file = files_.find(fd);
+  return file == files_.end() ? -1 : file->second;
+}
+
+bool Htif::inRam(uint32_t addr, uint64_t len) const {
+  const uint64_t offset = static_cast<uint32_t>(addr - memory_.base());
+  return offset < memory_.size() && len <= memory_.size() - offset;
+}
+
+uint64_t Htif::read64(uint32_t addr) const {
+  return memory_.read32(addr) | static_cast<uint64_t>(memory_.read32(addr + 4)) << 32;
+}
+
+void Htif::write64(uint32_t addr, uint64_t value) {
+  uint8_t out[8];
+  put64(out, value);
+  writeBlock(addr, out, sizeof(out));
+}
+
+void Htif::writeBlock(uint32_t addr, const uint8_t* data, uint32_t len) {
+  memory_.writeBlock(addr, data, len);
+  if (mirror_ != nullptr) {
+    mirror_->writeBlock(addr, data, len);
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "guest_bus.h"
+#include "memory.h"
+
+// Host-target interface over the tohost/fromhost mailboxes, as used by
+// riscv-tests and newlib's libgloss-htif. A store to tohost's low word is
+//
+//   odd   exit: the guest is done, with exit code value >> 1 (1 is a pass)
+//   even  a syscall: value points at uint64_t magic_mem[8] holding the
+//         RISC-V Linux syscall number and up to seven arguments
+//
+// A syscall runs on the host at once. Its result (or -errno) replaces
+// magic_mem[0], tohost is cleared and fromhost is set to 1, which is what the
+// guest spins on. Supported: exit, exit_group, read, write, openat, open,
+// close, lseek and fstat; anything else returns -ENOSYS. Guest fds 0, 1 and 2
+// are the host's stdin and the guest console; files the guest opens are
+// opened on the host relative to the working directory. Without host I/O,
+// open and stdin reads fail with -EACCES so a rerun cannot touch host files.
+class Htif {
+ public:
+  // `mirror`, if set, receives every guest memory write the proxy makes (the
+  // --cosim reference memory).
+  Htif(Memory& memory, uint32_t tohost, uint32_t fromhost, GuestConsole& console,
+       Memory* mirror = nullptr, bool host_io = true);
+  ~Htif();
+
+  Htif(const Htif&) = delete;
+  Htif& operator=(const Htif&) = delete;
+
+  // Handles a nonzero store to tohost. Returns true once the guest has
+  // exited; exitValue() is then its odd-encoded exit code. An even value
+  // with no fromhost symbol to reply through is taken as the exit value.
+  bool store(uint32_t value);
+
+  uint32_t exitValue() const { return exit_value_; }
+
+  // True while the guest holds host files open; checkpoints cannot save them.
+  bool hasOpenFiles() const { return !files_.empty(); }
+
+ private:
+  int64_t syscall(const std::vector<uint64_t>& args, bool& exited);
+  int64_t open(uint32_t path_addr, uint64_t flags, uint64_t mode);
+  int64_t read(int64_t fd, uint32_t buf, uint64_t len);
+  int64_t write(int64_t fd, uint32_t buf, uint64_t len);
+  int64_t fstat(int64_t fd, uint32_t buf);
+  int hostFd(int64_t fd) const;
+  bool inRam(uint32_t addr, uint64_t len) const;
+  uint64_t read64(uint32_t addr) const;
+  void write64(uint32_t addr, uint64_t value);
+  void writeBlock(uint32_t addr, const uint8_t* data, uint32_t len);
+
+  Memory& memory_;
+  Memory* mirror_;
+  uint32_t tohost_;
+  uint32_t fromhost_;
+  GuestConsole& console_;
+  bool host_io_;
+  std::map<int64_t, int> files_;  // guest fd >= 3 -> host fd
+  uint32_t exit_value_ = 0;
+  std::vector<uint64_t> warned_;  // unsupported syscalls already reported
+};
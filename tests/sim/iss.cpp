@@ -0,0 +1,206 @@
+#include "iss.h"
+
+namespace {
+
+constexpr uint32_t kOpLoad = 0x03;
+constexpr uint32_t kOpMiscMem = 0x0f;
+constexpr uint32_t kOpImm = 0x13;
+constexpr uint32_t kOpAuipc = 0x17;
+constexpr uint32_t kOpStore = 0x23;
+constexpr uint32_t kOpReg = 0x33;
+constexpr uint32_t kOpLui = 0x37;
+constexpr uint32_t kOpBranch = 0x63;
+constexpr uint32_t kOpJalr = 0x67;
+constexpr uint32_t kOpJal = 0x6f;
+constexpr uint32_t kOpSystem = 0x73;
+
+int32_t signExtend(uint32_t value, unsigned bits) {
+  const uint32_t shift = 32 - bits;
+  return static_cast<int32_t>(value << shift) >> shift;
+}
+
+uint32_t immI(uint32_t instr) {
+  return static_cast<uint32_t>(static_cast<int32_t>(instr) >> 20);
+}
+
+uint32_t immS(uint32_t instr) {
+  return static_cast<uint32_t>(signExtend(((instr >> 25) << 5) | ((instr >> 7) & 0x1f), 12));
+}
+
+uint32_t immB(uint32_t instr) {
+  const uint32_t imm = (((instr >> 31) & 0x1) << 12) | (((instr >> 7) & 0x1) << 11) |
+                       (((instr >> 25) & 0x3f) << 5) | (((instr >> 8) & 0xf) << 1);
+  return static_cast<uint32_t>(signExtend(imm, 13));
+}
+
+uint32_t immJ(uint32_t instr) {
+  const uint32_t imm = (((instr >> 31) & 0x1) << 20) | (((instr >> 12) & 0xff) << 12) |
+                       (((instr >> 20) & 0x1) << 11) | (((instr >> 21) & 0x3ff) << 1);
+  return static_cast<uint32_t>(signExtend(imm, 21));
+}
+
+uint32_t aluOp(uint32_t funct3, bool alt, uint32_t a, uint32_t b) {
+  const uint32_t shamt = b & 31;
+  switch (funct3) {
+    case 0: return alt ? a - b : a + b;
+    case 1: return a << shamt;
+    case 2: return static_cast<int32_t>(a) < static_cast<int32_t>(b) ? 1 : 0;
+    case 3: return a < b ? 1 : 0;
+    case 4: return a ^ b;
+    case 5: return alt ? static_cast<uint32_t>(static_cast<int32_t>(a) >> shamt) : a >> shamt;
+    case 6: return a | b;
+    default: return a & b;
+  }
+}
+
+uint32_t mulDivOp(uint32_t funct3, uint32_t a, uint32_t b) {
+  const int32_t sa = static_cast<int32_t>(a);
+  const int32_t sb = static_cast<int32_t>(b);
+  switch (funct3) {
+    case 0:  // MUL
+      return a * b;
+    case 1:  // MULH
+      return static_cast<uint32_t>((static_cast<int64_t>(sa) * sb) >> 32);
+    case 2:  // MULHSU
+      return static_cast<uint32_t>((static_cast<int64_t>(sa) * static_cast<int64_t>(b)) >> 32);
+    case 3:  // MULHU
+      return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) >> 32);
+    case 4:  // DIV
+      if (b == 0) {
+        return 0xffffffffu;
+      }
+      if (a == 0x80000000u && b == 0xffffffffu) {
+        return a;
+      }
+      return static_cast<uint32_t>(sa / sb);
+    case 5:  // DIVU
+      return b == 0 ? 0xffffffffu : a / b;
+    case 6:  // REM
+      if (b == 0) {
+        return a;
+      }
+      if (a == 0x80000000u && b == 0xffffffffu) {
+        return 0;
+      }
+      return static_cast<uint32_t>(sa % sb);
+    default:  // REMU
+      return b == 0 ? a : a % b;
+  }
+}
+
+bool branchTaken(uint32_t funct3, uint32_t a, uint32_t b) {
+  switch (funct3) {
+    case 0: return a == b;
+    case 1: return a != b;
+    case 4: return static_cast<int32_t>(a) < static_cast<int32_t>(b);
+    case 5: return static_cast<int32_t>(a) >= static_cast<int32_t>(b);
+    case 6: return a < b;
+    case 7: return a >= b;
+    default: return false;
+  }
+}
+
+}  // namespace
+
+uint32_t IssHart::load(uint32_t addr, uint32_t funct3) const {
+  switch (funct3) {
+    case 0: return static_cast<uint32_t>(static_cast<int8_t>(memory_.read8(addr)));
+    case 1:
+      return static_cast<uint32_t>(
+          static_cast<int16_t>(memory_.read8(addr) | (memory_.read8(addr + 1) << 8)));
+    case 4: return memory_.read8(addr);
+    case 5: return memory_.read8(addr) | (memory_.read8(addr + 1) << 8);
+    default: return memory_.read32(addr);
+  }
+}
+
+void IssHart::store(uint32_t addr, uint32_t funct3, uint32_t value) {
+  switch (funct3) {
+    case 0:
+      memory_.write8(addr, static_cast<uint8_t>(value));
+      break;
+    case 1:
+      memory_.write8(addr, static_cast<uint8_t>(value));
+      memory_.write8(addr + 1, static_cast<uint8_t>(value >> 8));
+      break;
+    default:
+      memory_.write32(addr, value);
+      break;
+  }
+}
+
+IssRetire IssHart::step() {
+  IssRetire retire;
+  const uint32_t instr = memory_.read32(pc_);
+  retire.pc = pc_;
+  retire.instr = instr;
+
+  const uint32_t opcode = instr & 0x7f;
+  const uint32_t rd = (instr >> 7) & 0x1f;
+  const uint32_t funct3 = (instr >> 12) & 0x7;
+  const uint32_t funct7 = instr >> 25;
+  const uint32_t rs1 = regs_[(instr >> 15) & 0x1f];
+  const uint32_t rs2 = regs_[(instr >> 20) & 0x1f];
+
+  uint32_t next_pc = pc_ + 4;
+  bool writes = false;
+  uint32_t value = 0;
+
+  switch (opcode) {
+    case kOpLui:
+      writes = true;
+      value = instr & 0xfffff000u;
+      break;
+    case kOpAuipc:
+      writes = true;
+      value = pc_ + (instr & 0xfffff000u);
+      break;
+    case kOpJal:
+      writes = true;
+      value = pc_ + 4;
+      next_pc = pc_ + immJ(instr);
+      break;
+    case kOpJalr:
+      writes = true;
+      value = pc_ + 4;
+      next_pc = (rs1 + immI(instr)) & ~1u;
+      break;
+    case kOpBranch:
+      if (branchTaken(funct3, rs1, rs2)) {
+        next_pc = pc_ + immB(instr);
+      }
+      break;
+    case kOpLoad:
+      writes = true;
+      value = load(rs1 + immI(instr), funct3);
+      break;
+    case kOpStore:
+      store(rs1 + immS(instr), funct3, rs2);
+      break;
+    case kOpImm:
+      writes = true;
+      // Only the shifts use funct7 (bit 30 selects SRAI); elsewhere it is immediate.
+      value = aluOp(funct3, funct3 == 5 && (funct7 & 0x20) != 0, rs1, immI(instr));
+      break;
+    case kOpReg:
+      writes = true;
+      value = funct7 == 0x01 ? mulDivOp(funct3, rs1, rs2)
+                             : aluOp(funct3, (funct7 & 0x20) != 0, rs1, rs2);
+      break;
+    case kOpSystem:
+      retire.csr = funct3 != 0;  // ECALL, EBREAK, xRET and WFI have funct3 0
+      break;
+    case kOpMiscMem:
+    default:
+      break;
+  }
+
+  if (writes && rd != 0) {
+    regs_[rd] = value;
+    retire.rd = rd;
+    retire.rd_value = value;
+  }
+  pc_ = next_pc;
+  retire.next_pc = next_pc;
+  return retire;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "memory.h"
+
+// One instruction retired by the reference interpreter.
+struct IssRetire {
+  uint32_t pc = 0;
+  uint32_t instr = 0;
+  uint32_t next_pc = 0;
+  uint32_t rd = 0;  // 0 when the instruction writes no register
+  uint32_t rd_value = 0;
+  bool csr = false;  // a CSR instruction; its rd value is not modelled
+};
+
+// RV32IM reference interpreter for lockstep co-simulation. It models the ISA
+// the way the Nyte cores implement it rather than a full privileged machine:
+// there are no traps, SYSTEM and FENCE retire as no-ops, and misaligned
+// accesses are performed a byte at a time. There are no CSRs either: a CSR
+// instruction writes nothing and is flagged so the caller can supply rd with
+// setReg(). Several harts may share one Memory.
+class IssHart {
+ public:
+  IssHart(Memory& memory, uint32_t reset_pc) : memory_(memory), pc_(reset_pc) {}
+
+  // Executes the instruction at pc() and returns what it retired.
+  IssRetire step();
+
+  uint32_t pc() const { return pc_; }
+  uint32_t reg(unsigned index) const { return regs_[index & 31]; }
+  void setReg(unsigned index, uint32_t value) {
+    if ((index & 31) != 0) {
+      regs_[index & 31] = value;
+    }
+  }
+
+ private:
+  uint32_t load(uint32_t addr, uint32_t funct3) const;
+  void store(uint32_t addr, uint32_t funct3, uint32_t value);
+
+  Memory& memory_;
+  uint32_t pc_;
+  std::array<uint32_t, 32> regs_{};
+};
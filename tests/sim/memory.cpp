@@ -1,36 +1,59 @@
 #include "memory.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <stdexcept>
 
 Memory::Memory(uint32_t base_addr, uint32_t size_bytes)
-    : base_(base_addr), size_(size_bytes) {}
-
-uint8_t Memory::read8(uint32_t addr) const {
-  auto it = data_.find(addr);
-  if (it == data_.end()) {
-    return 0;
+    : base_(base_addr), size_((size_bytes + kPageMask) & ~kPageMask) {
+  if ((base_ & kPageMask) != 0) {
+    throw std::invalid_argument("memory base must be page aligned");
+  }
+  if (size_ < size_bytes || (size_ != 0 && base_ + (size_ - 1) < base_)) {
+    throw std::invalid_argument("memory window exceeds 32-bit address space");
   }
-  return it->second;
+  pages_.resize(size_ >> kPageBits);
 }
 
-uint32_t Memory::read32(uint32_t addr) const {
-  uint32_t value = 0;
-  for (int i = 0; i < 4; ++i) {
-    value |= static_cast<uint32_t>(read8(addr + i)) << (8 * i);
+uint8_t* Memory::touchPage(uint32_t addr) {
+  const uint32_t offset = addr - base_;
+  std::unique_ptr<Page>& slot =
+      offset < size_ ? pages_[offset >> kPageBits] : stray_pages_[addr >> kPageBits];
+  if (!slot) {
+    slot = std::make_unique<Page>();  // value-initialized, i.e. zero filled
   }
-  return value;
+  return slot->data();
 }
 
 void Memory::write8(uint32_t addr, uint8_t data) {
-  data_[addr] = data;
+  touchPage(addr)[addr & kPageMask] = data;
+}
+
+void Memory::writeBlock(uint32_t addr, const uint8_t* src, uint32_t len) {
+  while (len != 0) {
+    const uint32_t chunk = std::min(len, kPageSize - (addr & kPageMask));
+    std::memcpy(touchPage(addr) + (addr & kPageMask), src, chunk);
+    addr += chunk;
+    src += chunk;
+    len -= chunk;
+  }
+}
+
+void Memory::fill(uint32_t addr, uint8_t value, uint32_t len) {
+  while (len != 0) {
+    const uint32_t chunk = std::min(len, kPageSize - (addr & kPageMask));
+    std::memset(touchPage(addr) + (addr & kPageMask), value, chunk);
+    addr += chunk;
+    len -= chunk;
+  }
 }
 
-void Memory::write32(uint32_t addr, uint32_t data) {
-  for (int i = 0; i < 4; ++i) {
-    write8(addr + i, static_cast<uint8_t>((data >> (8 * i)) & 0xFFu));
+void Memory::clear() {
+  for (auto& page : pages_) {
+    page.reset();
   }
+  stray_pages_.clear();
 }
 
 void Memory::dumpSignature(uint32_t begin, uint32_t end, const std::string& path) const {
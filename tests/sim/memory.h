@@ -1,11 +1,23 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+// Sparse guest RAM backed by lazily allocated 4 KB pages. Addresses inside
+// [base, base + size) resolve through a flat page table; anything outside that
+// window falls back to a hash map of pages so stray accesses still behave like
+// the old byte map (reads return zero, writes are retained).
 class Memory {
  public:
+  static constexpr uint32_t kPageBits = 12;
+  static constexpr uint32_t kPageSize = 1u << kPageBits;
+  static constexpr uint32_t kPageMask = kPageSize - 1;
+
   Memory(uint32_t base_addr, uint32_t size_bytes);
 
   uint8_t read8(uint32_t addr) const;
@@ -13,11 +25,109 @@ class Memory {
 
   void write8(uint32_t addr, uint8_t data);
   void write32(uint32_t addr, uint32_t data);
+  // Writes the bytes of `data` selected by the low four bits of `mask`
+  // (bit i -> byte lane i), matching the cores' store-unit byte enables.
+  void writeMasked(uint32_t addr, uint32_t data, uint32_t mask);
+  // Bulk range operations used by the loaders; both walk the range a page at
+  // a time instead of issuing one write8 per byte.
+  void writeBlock(uint32_t addr, const uint8_t* src, uint32_t len);
+  void fill(uint32_t addr, uint8_t value, uint32_t len);
+
+  // Releases every page so the next test starts from all-zero memory.
+  void clear();
 
   void dumpSignature(uint32_t begin, uint32_t end, const std::string& path) const;
 
+  uint32_t base() const { return base_; }
+  uint32_t size() const { return size_; }
+
+  // True if `addr` lies outside the window on a page that has been written,
+  // e.g. an ELF segment or boot stub placed there by a loader.
+  bool strayMapped(uint32_t addr) const {
+    return addr - base_ >= size_ && stray_pages_.count(addr >> kPageBits) != 0;
+  }
+
+  // Calls fn(page_addr, const uint8_t* page_data) for every allocated page,
+  // in no particular order. Used to snapshot memory for checkpoints.
+  template <typename Fn>
+  void forEachPage(Fn&& fn) const;
+
  private:
+  using Page = std::array<uint8_t, kPageSize>;
+
+  const uint8_t* findPage(uint32_t addr) const;
+  uint8_t* touchPage(uint32_t addr);
+
   uint32_t base_;
   uint32_t size_;
-  std::unordered_map<uint32_t, uint8_t> data_;
+  std::vector<std::unique_ptr<Page>> pages_;
+  std::unordered_map<uint32_t, std::unique_ptr<Page>> stray_pages_;
 };
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Memory word accessors assume a little-endian host");
+
+inline const uint8_t* Memory::findPage(uint32_t addr) const {
+  const uint32_t offset = addr - base_;
+  if (offset < size_) {
+    return pages_[offset >> kPageBits] ? pages_[offset >> kPageBits]->data() : nullptr;
+  }
+  auto it = stray_pages_.find(addr >> kPageBits);
+  return it == stray_pages_.end() ? nullptr : it->second->data();
+}
+
+inline uint8_t Memory::read8(uint32_t addr) const {
+  const uint8_t* page = findPage(addr);
+  return page ? page[addr & kPageMask] : 0;
+}
+
+inline uint32_t Memory::read32(uint32_t addr) const {
+  if ((addr & 0x3u) == 0) {
+    const uint8_t* page = findPage(addr);
+    if (page == nullptr) {
+      return 0;
+    }
+    uint32_t value;
+    std::memcpy(&value, page + (addr & kPageMask), sizeof(value));
+    return value;
+  }
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(read8(addr + i)) << (8 * i);
+  }
+  return value;
+}
+
+inline void Memory::write32(uint32_t addr, uint32_t data) {
+  if ((addr & 0x3u) == 0) {
+    std::memcpy(touchPage(addr) + (addr & kPageMask), &data, sizeof(data));
+    return;
+  }
+  for (int i = 0; i < 4; ++i) {
+    write8(addr + i, static_cast<uint8_t>((data >> (8 * i)) & 0xFFu));
+  }
+}
+
+inline void Memory::writeMasked(uint32_t addr, uint32_t data, uint32_t mask) {
+  if ((mask & 0xFu) == 0xFu) {
+    write32(addr, data);
+    return;
+  }
+  for (int i = 0; i < 4; ++i) {
+    if ((mask >> i) & 0x1u) {
+      write8(addr + i, static_cast<uint8_t>((data >> (8 * i)) & 0xFFu));
+    }
+  }
+}
+
+template <typename Fn>
+void Memory::forEachPage(Fn&& fn) const {
+  for (size_t i = 0; i < pages_.size(); ++i) {
+    if (pages_[i]) {
+      fn(base_ + static_cast<uint32_t>(i << kPageBits), pages_[i]->data());
+    }
+  }
+  for (const auto& entry : stray_pages_) {
+    fn(entry.first << kPageBits, entry.second->data());
+  }
+}
@@ -0,0 +1,35 @@
+#include "VTetraNyteTLToAHBLite.h"
+#include "memport_main.h"
+
+namespace {
+// TetraNyteTLToAHBLite: the legacy port behind the TL-UL to AXI4-Lite to
+// AHB-Lite bridge chain, one transfer at a time.
+struct AhbLiteTarget {
+  using Model = VTetraNyteTLToAHBLite;
+  using Slave = AhbLiteSlave;
+  static constexpr char kName[] = "memport_ahblite";
+
+  static void toSlave(const Model& dut, AhbLitePins& pins) {
+    pins.haddr = dut.io_ahb_haddr;
+    pins.hwrite = dut.io_ahb_hwrite;
+    pins.htrans = dut.io_ahb_htrans;
+    pins.hsize = dut.io_ahb_hsize;
+    pins.hsel = dut.io_ahb_hsel;
+    pins.hwdata = dut.io_ahb_hwdata;
+  }
+
+  static void fromSlave(Model& dut, const AhbLitePins& pins) {
+    dut.io_ahb_hrdata = pins.hrdata;
+    dut.io_ahb_hready = pins.hready;
+    dut.io_ahb_hresp = pins.hresp;
+  }
+
+  static bool requestTaken(const Model& dut, const AhbLitePins&) { return dut.io_legacy_ready; }
+
+  static bool responseValid(const Model& dut, const AhbLitePins&) {
+    return dut.io_legacy_respValid;
+  }
+};
+}  // namespace
+
+int main(int argc, char** argv) { return memPortMain<AhbLiteTarget>(argc, argv); }
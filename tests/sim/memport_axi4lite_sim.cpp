@@ -0,0 +1,43 @@
+#include "VTetraNyteTLToAXI4Lite.h"
+#include "memport_main.h"
+
+namespace {
+// TetraNyteTLToAXI4Lite: the legacy port behind the single-outstanding
+// TL-UL to AXI4-Lite bridge.
+struct Axi4LiteTarget {
+  using Model = VTetraNyteTLToAXI4Lite;
+  using Slave = Axi4LiteSlave;
+  static constexpr char kName[] = "memport_axi4lite";
+
+  static void toSlave(const Model& dut, Axi4LitePins& pins) {
+    pins.aw_valid = dut.io_axi_aw_valid;
+    pins.aw_addr = dut.io_axi_aw_bits_addr;
+    pins.w_valid = dut.io_axi_w_valid;
+    pins.w_data = dut.io_axi_w_bits_data;
+    pins.w_strb = dut.io_axi_w_bits_strb;
+    pins.b_ready = dut.io_axi_b_ready;
+    pins.ar_valid = dut.io_axi_ar_valid;
+    pins.ar_addr = dut.io_axi_ar_bits_addr;
+    pins.r_ready = dut.io_axi_r_ready;
+  }
+
+  static void fromSlave(Model& dut, const Axi4LitePins& pins) {
+    dut.io_axi_aw_ready = pins.aw_ready;
+    dut.io_axi_w_ready = pins.w_ready;
+    dut.io_axi_b_valid = pins.b_valid;
+    dut.io_axi_b_bits_resp = pins.b_resp;
+    dut.io_axi_ar_ready = pins.ar_ready;
+    dut.io_axi_r_valid = pins.r_valid;
+    dut.io_axi_r_bits_data = pins.r_data;
+    dut.io_axi_r_bits_resp = pins.r_resp;
+  }
+
+  static bool requestTaken(const Model& dut, const Axi4LitePins&) { return dut.io_legacy_ready; }
+
+  static bool responseValid(const Model& dut, const Axi4LitePins&) {
+    return dut.io_legacy_respValid;
+  }
+};
+}  // namespace
+
+int main(int argc, char** argv) { return memPortMain<Axi4LiteTarget>(argc, argv); }
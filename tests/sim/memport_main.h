@@ -0,0 +1,334 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "bus_slave.h"
+#include "memory.h"
+#include "verilated.h"
+
+// The harness shared by the bus-level MemPort targets. Each memport_<bus>_sim.cpp
+// wraps one MemPort top (legacy request in, bus master out) and defines a
+// target struct with:
+//
+//   Model, Slave                  Verilated top and the bus_slave.h model
+//   kName                         name for the summary and --stats
+//   toSlave(dut, pins)            copy the master's bus outputs into pins
+//   fromSlave(dut, pins)          drive the slave's outputs into the DUT
+//   requestTaken(dut, pins)       the offered legacy request is accepted at
+//                                 the coming edge
+//   responseValid(dut, pins)      legacy.readData carries the oldest request's
+//                                 response this cycle
+//
+// The harness replays a synthetic stream of loads and stores through the
+// legacy port, holding each request until it is taken, and checks every load
+// against a reference memory. Exit codes: 0 pass, 1 argument error, 3 max
+// cycles reached, 5 load data mismatch.
+
+struct MemPortOptions {
+  uint64_t requests = 100'000;
+  unsigned read_percent = 70;
+  bool sequential = false;         // --pattern seq: walk the footprint word by word
+  uint32_t footprint = 64 * 1024;  // bytes touched, from the memory base
+  uint64_t seed = 1;
+  BusTiming timing;
+  uint64_t max_cycles = 10'000'000;
+  std::string stats;
+};
+
+namespace memport_detail {
+
+constexpr uint32_t kMemBase = 0x80000000;
+constexpr int kResetCycles = 5;
+
+inline MemPortOptions parseOptions(int argc, char** argv) {
+  MemPortOptions opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "--requests" && i + 1 < argc) {
+      opts.requests = std::stoull(argv[++i]);
+    } else if (arg == "--read-percent" && i + 1 < argc) {
+      opts.read_percent = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else if (arg == "--pattern" && i + 1 < argc) {
+      const std::string pattern(argv[++i]);
+      if (pattern != "seq" && pattern != "random") {
+        throw std::invalid_argument("--pattern must be seq or random");
+      }
+      opts.sequential = pattern == "seq";
+    } else if (arg == "--footprint" && i + 1 < argc) {
+      opts.footprint = static_cast<uint32_t>(std::stoul(argv[++i], nullptr, 0));
+    } else if (arg == "--seed" && i + 1 < argc) {
+      opts.seed = std::stoull(argv[++i]);
+    } else if (arg == "--wait-states" && i + 1 < argc) {
+      opts.timing.wait_states = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else if (arg == "--backpressure" && i + 1 < argc) {
+      opts.timing.backpressure = argv[++i];
+    } else if (arg == "--max-outstanding" && i + 1 < argc) {
+      opts.timing.max_outstanding = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else if (arg == "--max-cycles" && i + 1 < argc) {
+      opts.max_cycles = std::stoull(argv[++i]);
+    } else if (arg == "--stats" && i + 1 < argc) {
+      opts.stats = argv[++i];
+    } else if (arg.rfind("+", 0) == 0) {
+      // Verilator runtime plusarg, handled by commandArgs.
+    } else {
+      throw std::invalid_argument("unknown or incomplete argument: " + arg);
+    }
+  }
+  if (opts.read_percent > 100) {
+    throw std::invalid_argument("--read-percent must be at most 100");
+  }
+  if (opts.footprint < 4 || opts.footprint % 4 != 0) {
+    throw std::invalid_argument("--footprint must be a non-zero multiple of 4");
+  }
+  validateBusTiming(opts.timing);
+  return opts;
+}
+
+// One legacy-port request; mask 0 is a load of the whole word.
+struct Request {
+  uint32_t addr;
+  uint32_t data;
+  uint32_t mask;
+};
+
+// Loads are word aligned; stores are a byte, halfword or word at a naturally
+// aligned address, with the data in its byte lanes as the cores issue them.
+class RequestStream {
+ public:
+  explicit RequestStream(const MemPortOptions& options)
+      : options_(options), rng_(options.seed) {}
+
+  Request next() {
+    const uint32_t words = options_.footprint / 4;
+    const uint32_t word = options_.sequential ? static_cast<uint32_t>(index_++ % words)
+                                              : static_cast<uint32_t>(rng_() % words);
+    Request request{kMemBase + word * 4, static_cast<uint32_t>(rng_()), 0};
+    if (rng_() % 100 < options_.read_percent) {
+      return request;
+    }
+    switch (rng_() % 3) {
+      case 0: {
+        const uint32_t lane = static_cast<uint32_t>(rng_() % 4);
+        request.addr += lane;
+        request.mask = 0x1u << lane;
+        break;
+      }
+      case 1: {
+        const uint32_t lane = static_cast<uint32_t>(rng_() % 2) * 2;
+        request.addr += lane;
+        request.mask = 0x3u << lane;
+        break;
+      }
+      default:
+        request.mask = 0xFu;
+        break;
+    }
+    return request;
+  }
+
+ private:
+  const MemPortOptions& options_;
+  std::mt19937_64 rng_;
+  uint64_t index_ = 0;
+};
+
+// A request taken by the port and still waiting for its response.
+struct InFlight {
+  uint64_t offered;  // cycle the request was first offered
+  bool load;
+  uint32_t addr;
+  uint32_t expected;
+};
+
+struct Totals {
+  uint64_t cycles = 0;
+  uint64_t loads = 0;
+  uint64_t stores = 0;
+  uint64_t latency_sum = 0;
+  uint64_t latency_max = 0;
+};
+
+inline void writeStats(const std::string& path, const char* name, const MemPortOptions& options,
+                       int exit_code, const Totals& totals, const BusStats& bus, double wall_ms) {
+  const uint64_t done = totals.loads + totals.stores;
+  std::ofstream out(path);
+  out.precision(6);
+  out << "{\n"
+      << "  \"target\": \"" << name << "\",\n"
+      << "  \"exit_code\": " << exit_code << ",\n"
+      << "  \"wait_states\": " << options.timing.wait_states << ",\n"
+      << "  \"backpressure\": \"" << options.timing.backpressure << "\",\n"
+      << "  \"max_outstanding\": " << options.timing.max_outstanding << ",\n"
+      << "  \"cycles\": " << totals.cycles << ",\n"
+      << "  \"loads\": " << totals.loads << ",\n"
+      << "  \"stores\": " << totals.stores << ",\n"
+      << "  \"requests_per_cycle\": "
+      << (totals.cycles != 0 ? static_cast<double>(done) / totals.cycles : 0.0) << ",\n"
+      << "  \"latency_avg\": "
+      << (done != 0 ? static_cast<double>(totals.latency_sum) / done : 0.0) << ",\n"
+      << "  \"latency_max\": " << totals.latency_max << ",\n"
+      << "  \"slave_stall_cycles\": " << bus.stall_cycles << ",\n"
+      << "  \"slave_max_in_flight\": " << bus.max_in_flight << ",\n"
+      << "  \"slave_errors\": " << bus.errors << ",\n"
+      << "  \"wall_ms\": " << wall_ms << "\n"
+      << "}\n";
+  if (!out) {
+    throw std::runtime_error("cannot write " + path);
+  }
+}
+
+template <typename Target>
+int run(typename Target::Model& dut, const MemPortOptions& options, Totals& totals,
+        BusStats& bus) {
+  Memory memory(kMemBase, options.footprint);
+  Memory reference(kMemBase, options.footprint);
+  std::mt19937 fill(static_cast<uint32_t>(options.seed));
+  for (uint32_t addr = kMemBase; addr - kMemBase < options.footprint; addr += 4) {
+    const uint32_t word = fill();
+    memory.write32(addr, word);
+    reference.write32(addr, word);
+  }
+
+  typename Target::Slave slave(memory, options.timing);
+  typename Target::Slave::Pins pins;
+  RequestStream stream(options);
+  std::deque<InFlight> in_flight;
+
+  dut.io_passthroughMem_readData = 0;
+  dut.io_legacy_valid = 0;
+  dut.reset = 1;
+  for (int cycle = 0; cycle < kResetCycles; ++cycle) {
+    dut.clock = 0;
+    slave.drive(pins);
+    Target::fromSlave(dut, pins);
+    dut.eval();
+    dut.clock = 1;
+    dut.eval();
+  }
+  dut.reset = 0;
+
+  uint64_t issued = 0;
+  uint64_t done = 0;
+  Request request = stream.next();
+  uint64_t offered = 0;
+  uint64_t cycle = 0;
+  auto finish = [&](int exit_code) {
+    totals.cycles = cycle;
+    bus = slave.stats();
+    return exit_code;
+  };
+  for (; done < options.requests; ++cycle) {
+    if (cycle >= options.max_cycles) {
+      std::cerr << "Reached max cycles (" << options.max_cycles << ") with " << done << " of "
+                << options.requests << " requests done" << std::endl;
+      return finish(3);
+    }
+
+    dut.clock = 0;
+    slave.drive(pins);
+    Target::fromSlave(dut, pins);
+    const bool offering = issued < options.requests;
+    dut.io_legacy_valid = offering;
+    dut.io_legacy_addr = request.addr;
+    dut.io_legacy_writeData = request.data;
+    dut.io_legacy_writeMask = request.mask;
+    dut.eval();
+    Target::toSlave(dut, pins);
+
+    if (Target::responseValid(dut, pins)) {
+      if (in_flight.empty()) {
+        std::cerr << "cycle " << cycle << ": response with no request outstanding" << std::endl;
+        return finish(5);
+      }
+      const InFlight& oldest = in_flight.front();
+      if (oldest.load && dut.io_legacy_readData != oldest.expected) {
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "load 0x%08x returned 0x%08x, expected 0x%08x",
+                      oldest.addr, static_cast<uint32_t>(dut.io_legacy_readData),
+                      oldest.expected);
+        std::cerr << "cycle " << cycle << ": " << buf << std::endl;
+        return finish(5);
+      }
+      const uint64_t latency = cycle - oldest.offered;
+      totals.latency_sum += latency;
+      totals.latency_max = latency > totals.latency_max ? latency : totals.latency_max;
+      ++(oldest.load ? totals.loads : totals.stores);
+      in_flight.pop_front();
+      ++done;
+    }
+
+    if (offering && Target::requestTaken(dut, pins)) {
+      const bool load = request.mask == 0;
+      in_flight.push_back({offered, load, request.addr, load ? reference.read32(request.addr) : 0});
+      if (!load) {
+        reference.writeMasked(request.addr & ~0x3u, request.data, request.mask);
+      }
+      ++issued;
+      request = stream.next();
+      offered = cycle + 1;
+    }
+
+    slave.edge(pins);
+    dut.clock = 1;
+    dut.eval();
+  }
+  return finish(0);
+}
+
+}  // namespace memport_detail
+
+template <typename Target>
+int memPortMain(int argc, char** argv) {
+  Verilated::commandArgs(argc, argv);
+  MemPortOptions options;
+  try {
+    options = memport_detail::parseOptions(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << "Argument error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  VerilatedContext context;
+  context.commandArgs(argc, argv);
+  typename Target::Model dut(&context);
+  memport_detail::Totals totals;
+  BusStats bus;
+  const auto start = std::chrono::steady_clock::now();
+  const int exit_code = memport_detail::run<Target>(dut, options, totals, bus);
+  const double wall_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  dut.final();
+
+  const uint64_t done = totals.loads + totals.stores;
+  std::printf("%s: %llu requests (%llu loads, %llu stores) in %llu cycles, %.3f per cycle; "
+              "latency avg %.2f max %llu; slave stalled %llu cycles, %llu in flight at most\n",
+              Target::kName, static_cast<unsigned long long>(done),
+              static_cast<unsigned long long>(totals.loads),
+              static_cast<unsigned long long>(totals.stores),
+              static_cast<unsigned long long>(totals.cycles),
+              totals.cycles != 0 ? static_cast<double>(done) / totals.cycles : 0.0,
+              done != 0 ? static_cast<double>(totals.latency_sum) / done : 0.0,
+              static_cast<unsigned long long>(totals.latency_max),
+              static_cast<unsigned long long>(bus.stall_cycles),
+              static_cast<unsigned long long>(bus.max_in_flight));
+
+  if (options.stats.empty()) {
+    return exit_code;
+  }
+  try {
+    memport_detail::writeStats(options.stats, Target::kName, options, exit_code, totals, bus,
+                               wall_ms);
+  } catch (const std::exception& e) {
+    std::cerr << "Stats error: " << e.what() << std::endl;
+    return exit_code != 0 ? exit_code : 1;
+  }
+  return exit_code;
+}
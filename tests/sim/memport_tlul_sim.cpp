@@ -0,0 +1,45 @@
+#include "VZeroNyteMemPort.h"
+#include "memport_main.h"
+
+namespace {
+// ZeroNyteMemPort exposes its TL-UL master directly; a request is taken when
+// A fires, and D is always ready.
+struct TlUlTarget {
+  using Model = VZeroNyteMemPort;
+  using Slave = TlUlSlave;
+  static constexpr char kName[] = "memport_tlul";
+
+  static void toSlave(const Model& dut, TlUlPins& pins) {
+    pins.a_valid = dut.io_tl_a_valid;
+    pins.a_opcode = dut.io_tl_a_bits_opcode;
+    pins.a_size = dut.io_tl_a_bits_size;
+    pins.a_source = dut.io_tl_a_bits_source;
+    pins.a_mask = dut.io_tl_a_bits_mask;
+    pins.a_address = dut.io_tl_a_bits_address;
+    pins.a_data = dut.io_tl_a_bits_data;
+    pins.d_ready = dut.io_tl_d_ready;
+  }
+
+  static void fromSlave(Model& dut, const TlUlPins& pins) {
+    dut.io_tl_a_ready = pins.a_ready;
+    dut.io_tl_d_valid = pins.d_valid;
+    dut.io_tl_d_bits_opcode = pins.d_opcode;
+    dut.io_tl_d_bits_param = 0;
+    dut.io_tl_d_bits_size = pins.d_size;
+    dut.io_tl_d_bits_source = pins.d_source;
+    dut.io_tl_d_bits_denied = pins.d_denied;
+    dut.io_tl_d_bits_data = pins.d_data;
+    dut.io_tl_d_bits_corrupt = 0;
+  }
+
+  static bool requestTaken(const Model&, const TlUlPins& pins) {
+    return pins.a_valid && pins.a_ready;
+  }
+
+  static bool responseValid(const Model&, const TlUlPins& pins) {
+    return pins.d_valid && pins.d_ready;
+  }
+};
+}  // namespace
+
+int main(int argc, char** argv) { return memPortMain<TlUlTarget>(argc, argv); }
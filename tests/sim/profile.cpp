@@ -0,0 +1,145 @@
+#include "profile.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+Profiler::Profiler(ElfSymbolIndex index, unsigned num_threads)
+    : index_(std::move(index)), threads_(num_threads) {
+  // Nodes 0 .. num_threads-1 are the per-thread roots.
+  for (unsigned t = 0; t < num_threads; ++t) {
+    nodes_.push_back({t, kThreadRoot, 0});
+    threads_[t].node = t;
+  }
+}
+
+uint32_t Profiler::child(uint32_t parent, int function) {
+  const auto [it, inserted] =
+      children_.try_emplace({parent, function}, static_cast<uint32_t>(nodes_.size()));
+  if (inserted) {
+    nodes_.push_back({parent, function, nodes_[parent].depth + 1});
+  }
+  return it->second;
+}
+
+void Profiler::enter(Thread& t, uint32_t pc) {
+  const ElfFunction* found = index_.find(pc);
+  int function = kUnknown;
+  if (found != nullptr) {
+    function = static_cast<int>(found - index_.functions().data());
+    t.low = found->addr;
+    t.span = found->size;
+  } else {
+    t.low = pc;
+    t.span = 4;
+  }
+
+  if (t.transfer == Transfer::kCall && nodes_[t.node].depth < kMaxDepth) {
+    t.node = child(t.node, function);
+    return;
+  }
+  if (t.transfer == Transfer::kReturn && nodes_[t.node].depth > 1) {
+    t.node = nodes_[t.node].parent;
+  }
+  if (nodes_[t.node].function != function) {
+    const Node& top = nodes_[t.node];
+    t.node = child(top.depth == 0 ? t.node : top.parent, function);
+  }
+}
+
+std::string Profiler::functionName(int function) const {
+  return function == kUnknown ? "[unknown]" : index_.functions()[function].name;
+}
+
+void Profiler::write(const std::string& path, const char* core) const {
+  // Children are always created after their parents, so one backward pass
+  // accumulates each node's subtree total.
+  std::vector<uint64_t> total(nodes_.size());
+  for (size_t i = nodes_.size(); i-- > 0;) {
+    total[i] += nodes_[i].self;
+    if (nodes_[i].depth != 0) {
+      total[nodes_[i].parent] += total[i];
+    }
+  }
+
+  struct Row {
+    int function;
+    uint64_t self = 0;
+    uint64_t inclusive = 0;
+  };
+  std::vector<std::map<int, Row>> rows(threads_.size());
+  std::vector<uint32_t> root(nodes_.size());
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    const Node& node = nodes_[i];
+    root[i] = node.depth == 0 ? static_cast<uint32_t>(i) : root[node.parent];
+    if (node.depth == 0) {
+      continue;
+    }
+    Row& row = rows[root[i]].try_emplace(node.function, Row{node.function}).first->second;
+    row.self += node.self;
+    // A recursive function's inner frames are already inside its outer one.
+    bool nested = false;
+    for (const Node* up = &nodes_[node.parent]; up->depth != 0; up = &nodes_[up->parent]) {
+      nested |= up->function == node.function;
+    }
+    if (!nested) {
+      row.inclusive += total[i];
+    }
+  }
+
+  FILE* out = std::fopen(path.c_str(), "w");
+  if (out == nullptr) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  std::fprintf(out, "# %s guest profile, in retired instructions\n", core);
+  for (size_t t = 0; t < threads_.size(); ++t) {
+    const uint64_t retired = total[t];
+    if (retired == 0) {
+      continue;
+    }
+    std::vector<Row> sorted;
+    for (const auto& entry : rows[t]) {
+      sorted.push_back(entry.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Row& a, const Row& b) {
+      return a.self != b.self ? a.self > b.self : a.inclusive > b.inclusive;
+    });
+    std::fprintf(out, "\nthread %zu: %" PRIu64 " retired\n", t, retired);
+    std::fprintf(out, "%14s %7s %14s %7s  %s\n", "self", "self%", "inclusive", "incl%",
+                 "function");
+    for (const Row& row : sorted) {
+      std::fprintf(out, "%14" PRIu64 " %6.2f%% %14" PRIu64 " %6.2f%%  %s\n", row.self,
+                   100.0 * static_cast<double>(row.self) / static_cast<double>(retired),
+                   row.inclusive,
+                   100.0 * static_cast<double>(row.inclusive) / static_cast<double>(retired),
+                   functionName(row.function).c_str());
+    }
+  }
+  const bool flat_ok = std::ferror(out) == 0;
+  if (std::fclose(out) != 0 || !flat_ok) {
+    throw std::runtime_error("failed to write " + path);
+  }
+
+  const std::string folded_path = path + ".folded";
+  std::ofstream folded(folded_path, std::ios::trunc);
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (nodes_[i].self == 0) {
+      continue;
+    }
+    std::vector<std::string> frames;
+    size_t n = i;
+    for (; nodes_[n].depth != 0; n = nodes_[n].parent) {
+      frames.push_back(functionName(nodes_[n].function));
+    }
+    folded << "thread" << n;
+    for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+      folded << ';' << *frame;
+    }
+    folded << ' ' << nodes_[i].self << '\n';
+  }
+  if (!folded) {
+    throw std::runtime_error("failed to write " + folded_path);
+  }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "elf_loader.h"
+
+// Guest profiler for --profile. Every retirement is attributed to the
+// function containing its PC and to the guest call stack it ran under. The
+// stack is a shadow stack kept per hardware thread from the retire stream,
+// using the RISC-V link register convention: jal/jalr writing ra or t0 is a
+// call, jalr x0 through ra or t0 is a return, and any other move into a
+// different function (a tail call, a fall-through) replaces the top frame.
+//
+// write() produces a flat profile, self and inclusive retired instructions
+// per function and thread, and `<path>.folded`, the folded-stacks input of
+// flamegraph.pl with one "thread<N>;outer;...;inner count" line per stack.
+class Profiler {
+ public:
+  Profiler(ElfSymbolIndex index, unsigned num_threads);
+
+  void retire(unsigned thread, uint32_t pc, uint32_t instr) {
+    Thread& t = threads_[thread];
+    if (t.transfer != Transfer::kNone || pc - t.low >= t.span) {
+      enter(t, pc);
+    }
+    ++nodes_[t.node].self;
+    t.transfer = transferOf(instr);
+  }
+
+  // Throws std::runtime_error on I/O failure.
+  void write(const std::string& path, const char* core) const;
+
+ private:
+  enum class Transfer : uint8_t { kNone, kCall, kReturn };
+
+  static constexpr int kUnknown = -1;    // PC outside every indexed function
+  static constexpr int kThreadRoot = -2;
+  static constexpr unsigned kMaxDepth = 256;
+
+  // One distinct call stack, as a node of the calling-context tree.
+  struct Node {
+    uint32_t parent;
+    int function;  // index into the symbol index, kUnknown or kThreadRoot
+    unsigned depth;
+    uint64_t self = 0;
+  };
+
+  struct Thread {
+    uint32_t node;
+    uint32_t low = 0;   // current function's range; span 0 forces a lookup
+    uint32_t span = 0;
+    Transfer transfer = Transfer::kNone;
+  };
+
+  static bool isLink(uint32_t reg) { return reg == 1 || reg == 5; }
+
+  static Transfer transferOf(uint32_t instr) {
+    const uint32_t opcode = instr & 0x7f;
+    const uint32_t rd = (instr >> 7) & 0x1f;
+    if (opcode == 0x6f || opcode == 0x67) {
+      if (isLink(rd)) {
+        return Transfer::kCall;
+      }
+      if (opcode == 0x67 && rd == 0 && isLink((instr >> 15) & 0x1f)) {
+        return Transfer::kReturn;
+      }
+    }
+    return Transfer::kNone;
+  }
+
+  // Moves `t` to the stack for `pc` after a call, return or function change.
+  void enter(Thread& t, uint32_t pc);
+  uint32_t child(uint32_t parent, int function);
+  std::string functionName(int function) const;
+
+  ElfSymbolIndex index_;
+  std::vector<Node> nodes_;
+  std::map<std::pair<uint32_t, int>, uint32_t> children_;
+  std::vector<Thread> threads_;
+};
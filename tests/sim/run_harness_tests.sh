@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Builds and runs the harness self-tests that need no Verilated model.
+#
+# Usage: run_harness_tests.sh   (CXX selects the compiler, default g++)
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+BUILD_DIR="$SCRIPT_DIR/build"
+CXX=${CXX:-g++}
+
+mkdir -p "$BUILD_DIR"
+"$CXX" -std=c++17 -O1 -Wall -Wextra -I"$SCRIPT_DIR" -o "$BUILD_DIR/cosim_test" \
+  "$SCRIPT_DIR/cosim_test.cpp" "$SCRIPT_DIR/cosim.cpp" "$SCRIPT_DIR/iss.cpp" \
+  "$SCRIPT_DIR/memory.cpp"
+"$BUILD_DIR/cosim_test"
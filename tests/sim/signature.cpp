@@ -0,0 +1,119 @@
+#include "signature.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'Y', 'T', 'E', 'S', 'I', 'G', '1'};
+
+struct BinaryHeader {
+  char magic[8];
+  uint32_t begin;
+  uint32_t count;
+};
+
+std::string hex(uint32_t value) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "0x%08x", value);
+  return buf;
+}
+
+std::vector<uint32_t> parseHex(const std::string& path, const std::string& text) {
+  std::vector<uint32_t> words;
+  size_t line_no = 0;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t eol = text.find('\n', pos);
+    if (eol == std::string::npos) {
+      eol = text.size();
+    }
+    std::string line = text.substr(pos, eol - pos);
+    pos = eol + 1;
+    ++line_no;
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      continue;
+    }
+    if (line.size() > 8 || line.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+      throw std::runtime_error(path + ":" + std::to_string(line_no) + ": expected a hex word");
+    }
+    words.push_back(static_cast<uint32_t>(std::stoul(line, nullptr, 16)));
+  }
+  return words;
+}
+
+}  // namespace
+
+void writeSignature(const Memory& memory, uint32_t begin, uint32_t end, const std::string& path,
+                    bool binary) {
+  if (!binary) {
+    memory.dumpSignature(begin, end, path);
+    return;
+  }
+  if (end <= begin) {
+    throw std::runtime_error("invalid signature bounds");
+  }
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  BinaryHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.begin = begin;
+  header.count = (end - begin + 3) / 4;
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (uint32_t addr = begin; addr < end; addr += 4) {
+    const uint32_t value = memory.read32(addr);
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  if (!out) {
+    throw std::runtime_error("failed to write signature file");
+  }
+}
+
+std::vector<uint32_t> readSignature(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("failed to open signature file: " + path);
+  }
+  const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (data.size() < sizeof(kMagic) || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+    return parseHex(path, data);
+  }
+
+  BinaryHeader header{};
+  if (data.size() < sizeof(header)) {
+    throw std::runtime_error(path + ": truncated signature header");
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (data.size() - sizeof(header) != static_cast<uint64_t>(header.count) * 4) {
+    throw std::runtime_error(path + ": signature size does not match its word count");
+  }
+  std::vector<uint32_t> words(header.count);
+  std::memcpy(words.data(), data.data() + sizeof(header), words.size() * 4);
+  return words;
+}
+
+bool compareSignature(const Memory& memory, uint32_t begin, uint32_t end,
+                      const std::vector<uint32_t>& expected, std::string& mismatch) {
+  const size_t count = end > begin ? (end - begin + 3) / 4 : 0;
+  for (size_t i = 0; i < count && i < expected.size(); ++i) {
+    const uint32_t actual = memory.read32(begin + static_cast<uint32_t>(i * 4));
+    if (actual != expected[i]) {
+      mismatch = "offset " + hex(static_cast<uint32_t>(i * 4)) + " (address " +
+                 hex(begin + static_cast<uint32_t>(i * 4)) + "): got " + hex(actual) +
+                 ", expected " + hex(expected[i]);
+      return false;
+    }
+  }
+  if (count != expected.size()) {
+    const size_t common = count < expected.size() ? count : expected.size();
+    mismatch = "offset " + hex(static_cast<uint32_t>(common * 4)) + ": signature has " +
+               std::to_string(count) + " words, expected " + std::to_string(expected.size());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "memory.h"
+
+// Signature files. Two formats are understood:
+//   hex     one 8-digit hex word per line, as RISCOF writes and reads them
+//   binary  the 8-byte magic "NYTESIG1", then the begin address and word
+//           count as u32, then the words; all little-endian
+// readSignature detects the format from the magic.
+
+// Writes memory words in [begin, end) to `path`. Throws std::runtime_error on
+// invalid bounds or I/O failure.
+void writeSignature(const Memory& memory, uint32_t begin, uint32_t end, const std::string& path,
+                    bool binary);
+
+// Reads a signature in either format. Throws std::runtime_error if the file
+// cannot be read or is malformed.
+std::vector<uint32_t> readSignature(const std::string& path);
+
+// Compares memory words in [begin, end) against `expected`. On a difference
+// returns false and describes the first mismatching offset in `mismatch`.
+bool compareSignature(const Memory& memory, uint32_t begin, uint32_t end,
+                      const std::vector<uint32_t>& expected, std::string& mismatch);
@@ -0,0 +1,283 @@
+# Build helpers sourced by build_{zeronyte,tetranyte,octonyte,memport}_sim.sh.
+#
+# Builds are incremental. The harness sources shared by every core
+# (HARNESS_SOURCES) are compiled once per compiler/flag set into
+# $BUILD_DIR/harness/<key>/libnytesim.a. Each model is re-verilated only when
+# a hash of its Verilog inputs, the Verilator version and the flags changes;
+# otherwise the existing obj dir is rebuilt in place by make, which recompiles
+# just the harness main. ccache is used for all C++ compiles when installed.
+#
+# SIM_FLAVOR selects how the Verilated model and harness are compiled:
+#   debug (default)  --trace-fst (for --wave), -O2             -> <core>_sim
+#   fast             no tracing, --x-assign/--x-initial fast,
+#                    -O3 model code, LTO; -march=native when
+#                    SIM_NATIVE=1                              -> <core>_sim_fast
+#   pgo              fast + compiler PGO trained on the --batch
+#                    manifest in SIM_PGO_TRAIN; threaded models
+#                    (VERILATOR_THREADS) also get Verilator's
+#                    --prof-pgo schedule profile               -> <core>_sim_pgo
+#
+# Models are verilated with --savable (for --checkpoint-at/--restore) unless
+# VERILATOR_THREADS=N is set, which verilates with --threads N and --stats
+# instead and inserts "_mt" before the flavor suffix; VERILATOR_PROF_EXEC=1
+# also adds --prof-exec (run with +verilator+prof+exec+file+<path>, view with
+# verilator_gantt). When
+# SIM_BENCH_MANIFEST (default: SIM_PGO_TRAIN) names a batch manifest and the
+# debug binary exists, optimized flavors are timed against it and the
+# cycles/sec speedup is printed.
+#
+# Every build also produces $BUILD_DIR/trace_decode, which turns the binary
+# traces written by --log back into text, and $BUILD_DIR/coverage_merge, which
+# merges, reports on and ranks --coverage files.
+
+HARNESS_SOURCES=(elf_loader memory batch affinity trace_writer trace_sink iss cosim stats sim_options hang bus_slave thread_programs signature coverage profile guest_bus htif)
+
+# Usage: flavor_init <core>. Expects BUILD_DIR and OBJ_DIR; sets SIM_NAME,
+# OBJ_DIR, FLAVOR_VERILATOR_FLAGS, FLAVOR_MAKEFLAGS, FLAVOR_CFLAGS and
+# FLAVOR_LDFLAGS.
+flavor_init() {
+  local core="$1"
+  local suffix=""
+  SIM_FLAVOR=${SIM_FLAVOR:-debug}
+  FLAVOR_VERILATOR_FLAGS=()
+  FLAVOR_MAKEFLAGS=()
+  FLAVOR_CFLAGS="-std=c++17 -pthread"
+  FLAVOR_LDFLAGS="-pthread"
+
+  if [[ -n "${VERILATOR_THREADS:-}" ]]; then
+    suffix="_mt"
+    FLAVOR_VERILATOR_FLAGS+=(--threads "$VERILATOR_THREADS" --stats)
+    if [[ "${VERILATOR_PROF_EXEC:-0}" == "1" ]]; then
+      FLAVOR_VERILATOR_FLAGS+=(--prof-exec)
+    fi
+  else
+    # Single-threaded models are savable so the harnesses can honour
+    # --checkpoint-at and --restore.
+    FLAVOR_VERILATOR_FLAGS+=(--savable)
+    FLAVOR_CFLAGS="$FLAVOR_CFLAGS -DNYTE_SAVABLE=1"
+  fi
+
+  case "$SIM_FLAVOR" in
+    debug)
+      FLAVOR_VERILATOR_FLAGS+=(--trace-fst)
+      FLAVOR_CFLAGS="-O2 $FLAVOR_CFLAGS -DNYTE_WAVE=1"
+      FLAVOR_LDFLAGS="-O2 $FLAVOR_LDFLAGS"
+      ;;
+    fast|pgo)
+      suffix="${suffix}_$SIM_FLAVOR"
+      FLAVOR_VERILATOR_FLAGS+=(--x-assign fast --x-initial fast -O3)
+      FLAVOR_MAKEFLAGS+=(OPT_FAST=-O3 OPT_GLOBAL=-O3)
+      FLAVOR_CFLAGS="-O3 -flto=auto $FLAVOR_CFLAGS"
+      FLAVOR_LDFLAGS="-O3 -flto=auto $FLAVOR_LDFLAGS"
+      if [[ "${SIM_NATIVE:-0}" == "1" ]]; then
+        FLAVOR_CFLAGS="$FLAVOR_CFLAGS -march=native"
+        FLAVOR_LDFLAGS="$FLAVOR_LDFLAGS -march=native"
+      fi
+      ;;
+    *)
+      echo "Unknown SIM_FLAVOR '$SIM_FLAVOR' (expected debug, fast or pgo)" >&2
+      exit 1
+      ;;
+  esac
+
+  SIM_NAME="${core}_sim${suffix}"
+  OBJ_DIR="${OBJ_DIR}${suffix}"
+}
+
+# Usage: build_harness_lib <cflags>. Prints the absolute path of the harness
+# static library built with <cflags>, recompiling only stale objects.
+build_harness_lib() {
+  local cflags="$1"
+  local cxx=${CXX:-g++}
+  local key
+  key=$({ "$cxx" --version | head -n1; printf '%s\n' "$cflags"; } | sha256sum | cut -c1-16)
+  local lib_dir
+  lib_dir="$(pwd)/$BUILD_DIR/harness/$key"
+  local lib="$lib_dir/libnytesim.a"
+  mkdir -p "$lib_dir"
+
+  local launcher=()
+  if command -v ccache >/dev/null 2>&1; then
+    launcher=(ccache)
+  fi
+
+  local stale=0
+  local name
+  for name in "${HARNESS_SOURCES[@]}"; do
+    local src="$SIM_DIR/$name.cpp"
+    local obj="$lib_dir/$name.o"
+    if [[ ! -f "$obj" || -n "$(find "$src" "$SIM_DIR"/*.h -newer "$obj" -print -quit)" ]]; then
+      echo "Compiling harness $name.cpp" >&2
+      # shellcheck disable=SC2086 # cflags is a flag list
+      ${launcher[@]+"${launcher[@]}"} "$cxx" $cflags -c "$src" -o "$obj" >&2
+      stale=1
+    fi
+  done
+
+  if [[ "$stale" -eq 1 || ! -f "$lib" ]]; then
+    local ar_tool=ar
+    if command -v gcc-ar >/dev/null 2>&1; then
+      ar_tool=gcc-ar  # understands LTO objects
+    fi
+    rm -f "$lib"
+    (cd "$lib_dir" && "$ar_tool" rcs "$lib" "${HARNESS_SOURCES[@]/%/.o}")
+  fi
+  echo "$lib"
+}
+
+# Usage: build_trace_decode. Builds $BUILD_DIR/trace_decode if it is missing
+# or older than its sources.
+build_trace_decode() {
+  local cxx=${CXX:-g++}
+  local tool="$BUILD_DIR/trace_decode"
+  local src="$SIM_DIR/trace_decode.cpp"
+  if [[ ! -x "$tool" || -n "$(find "$src" "$SIM_DIR/trace_format.h" -newer "$tool" -print -quit)" ]]; then
+    echo "Compiling trace_decode"
+    "$cxx" -std=c++17 -O2 -o "$tool" "$src"
+  fi
+}
+
+# Usage: build_coverage_merge. Builds $BUILD_DIR/coverage_merge if it is
+# missing or older than its sources.
+build_coverage_merge() {
+  local cxx=${CXX:-g++}
+  local tool="$BUILD_DIR/coverage_merge"
+  local srcs=("$SIM_DIR/coverage_merge.cpp" "$SIM_DIR/coverage.cpp")
+  if [[ ! -x "$tool" || -n "$(find "${srcs[@]}" "$SIM_DIR/coverage.h" -newer "$tool" -print -quit)" ]]; then
+    echo "Compiling coverage_merge"
+    "$cxx" -std=c++17 -O2 -o "$tool" "${srcs[@]}"
+  fi
+}
+
+# Usage: verilate_cached <obj-dir> <model> <cflags> <ldflags> <harness-main>
+#                        <verilator args...>
+# Verilates into <obj-dir> unless its stamp matches the hash of the inputs,
+# then builds <obj-dir>/<model> with make, linked against the harness library.
+# Arguments that name files (the Verilog top, PGO profiles) are hashed by
+# content.
+verilate_cached() {
+  local obj_dir="$1"
+  local model="$2"
+  local cflags="$3"
+  local ldflags="$4"
+  local harness_main="$5"
+  shift 5
+
+  local harness_lib
+  harness_lib=$(build_harness_lib "$cflags")
+
+  local key
+  key=$({
+    verilator --version
+    printf '%s\n' "$cflags" "$ldflags" "$harness_main" "$harness_lib" "$@"
+    local arg
+    for arg in "$@"; do
+      if [[ -f "$arg" ]]; then
+        sha256sum "$arg"
+      fi
+    done
+  } | sha256sum | cut -d' ' -f1)
+
+  local stamp="$obj_dir/.verilate.sha256"
+  if [[ -f "$stamp" && "$(cat "$stamp")" == "$key" ]]; then
+    echo "Verilog and flags unchanged; reusing $obj_dir"
+  else
+    rm -rf "$obj_dir"
+    mkdir -p "$obj_dir"
+    verilator -cc "$@" \
+      --Mdir "$obj_dir" \
+      -CFLAGS "$cflags" \
+      -LDFLAGS "$ldflags $harness_lib" \
+      --exe "$harness_main"
+    echo "$key" >"$stamp"
+  fi
+
+  local make_args=(-C "$obj_dir" -f "$model.mk" -j "$(nproc)")
+  if command -v ccache >/dev/null 2>&1; then
+    make_args+=(OBJCACHE=ccache)
+  fi
+  # The harness library is not a make dependency of the model; force a relink.
+  rm -f "$obj_dir/$model"
+  make "${make_args[@]}" ${FLAVOR_MAKEFLAGS[@]+"${FLAVOR_MAKEFLAGS[@]}"} "$model"
+}
+
+# Usage: flavor_build <verilate-fn> <model-binary>. <verilate-fn> is called as
+#   <verilate-fn> <obj-dir> <cflags> <ldflags> [extra verilator args...]
+# and must leave <obj-dir>/<model-binary> behind. The pgo flavor calls it
+# twice around a training run.
+flavor_build() {
+  local verilate_fn="$1"
+  local model_binary="$2"
+
+  if [[ "$SIM_FLAVOR" != "pgo" ]]; then
+    "$verilate_fn" "$OBJ_DIR" "$FLAVOR_CFLAGS" "$FLAVOR_LDFLAGS" "${FLAVOR_VERILATOR_FLAGS[@]}"
+    return
+  fi
+
+  if [[ ! -f "${SIM_PGO_TRAIN:-}" ]]; then
+    echo "SIM_FLAVOR=pgo needs SIM_PGO_TRAIN=<batch manifest of training ELFs>" >&2
+    exit 1
+  fi
+
+  local profile_dir
+  profile_dir="$(pwd)/${OBJ_DIR}.profile"
+  rm -rf "$profile_dir"
+  mkdir -p "$profile_dir"
+  local prof_pgo=()
+  if [[ -n "${VERILATOR_THREADS:-}" ]]; then
+    prof_pgo=(--prof-pgo)
+  fi
+
+  echo "PGO: building instrumented model"
+  "$verilate_fn" "$OBJ_DIR" \
+    "$FLAVOR_CFLAGS -fprofile-generate=$profile_dir" \
+    "$FLAVOR_LDFLAGS -fprofile-generate=$profile_dir" \
+    "${FLAVOR_VERILATOR_FLAGS[@]}" ${prof_pgo[@]+"${prof_pgo[@]}"}
+
+  echo "PGO: training on $SIM_PGO_TRAIN"
+  "$OBJ_DIR/$model_binary" --batch "$SIM_PGO_TRAIN" >/dev/null || true
+  if [[ -f profile.vlt ]]; then
+    mv profile.vlt "$profile_dir/profile.vlt"
+  fi
+
+  echo "PGO: building optimized model"
+  local vlt_profile=()
+  if [[ -f "$profile_dir/profile.vlt" ]]; then
+    vlt_profile=("$profile_dir/profile.vlt")
+  fi
+  "$verilate_fn" "$OBJ_DIR" \
+    "$FLAVOR_CFLAGS -fprofile-use=$profile_dir -fprofile-partial-training -Wno-missing-profile" \
+    "$FLAVOR_LDFLAGS -fprofile-use=$profile_dir -fprofile-partial-training" \
+    "${FLAVOR_VERILATOR_FLAGS[@]}" ${vlt_profile[@]+"${vlt_profile[@]}"}
+}
+
+# Prints the aggregate simulated cycles per wall-clock second of a --batch run.
+flavor_cycles_per_sec() {
+  { "$1" --batch "$2" 2>/dev/null || true; } | awk '
+    /^result / {
+      for (i = 2; i <= NF; ++i) {
+        split($i, kv, "=")
+        if (kv[1] == "cycles") cycles += kv[2]
+        if (kv[1] == "wall_ms") wall_ms += kv[2]
+      }
+    }
+    END { printf "%.0f\n", (wall_ms > 0) ? cycles / (wall_ms / 1000) : 0 }'
+}
+
+# Usage: flavor_report <debug-binary>. Compares $BUILD_DIR/$SIM_NAME against
+# the debug build on SIM_BENCH_MANIFEST.
+flavor_report() {
+  local debug_binary="$1"
+  local manifest="${SIM_BENCH_MANIFEST:-${SIM_PGO_TRAIN:-}}"
+  if [[ "$SIM_FLAVOR" == "debug" || -z "$manifest" || ! -x "$debug_binary" ]]; then
+    return
+  fi
+  local base_rate flavor_rate
+  base_rate=$(flavor_cycles_per_sec "$debug_binary" "$manifest")
+  flavor_rate=$(flavor_cycles_per_sec "$BUILD_DIR/$SIM_NAME" "$manifest")
+  awk -v base="$base_rate" -v fast="$flavor_rate" -v name="$SIM_NAME" 'BEGIN {
+    printf "%s: %d cycles/s vs %d cycles/s debug", name, fast, base
+    if (base > 0) printf " (%.2fx)", fast / base
+    printf "\n"
+  }'
+}
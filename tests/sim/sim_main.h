@@ -0,0 +1,885 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "affinity.h"
+#include "batch.h"
+#include "checkpoint.h"
+#include "cosim.h"
+#include "coverage.h"
+#include "elf_loader.h"
+#include "guest_bus.h"
+#include "hang.h"
+#include "htif.h"
+#include "memory.h"
+#include "profile.h"
+#include "signature.h"
+#include "sim_options.h"
+#include "stats.h"
+#include "thread_programs.h"
+#include "trace_sink.h"
+#include "verilated.h"
+#include "wave.h"
+
+// The harness shared by every core. Each <core>_sim.cpp defines a traits
+// struct for its Verilated model and calls simMain<Traits>(argc, argv). The
+// traits supply:
+//
+//   Model, Record                 Verilated model and trace record types
+//   kName, kTraceCore             name for checkpoints/stats, trace core id
+//   kNumThreads, kFetchWidth      hardware threads, instructions per fetch
+//   kTraceDetailFlag              the core's extra trace flag, or nullptr
+//   kRetireAtLowPhase             retirements are sampled before the rising
+//                                 edge rather than after it
+//   FetchState                    fetch bookkeeping, saved in checkpoints
+//   pc<T>(dut)                    thread T's PC port
+//   threadEnable<T>(dut)          thread T's enable input (multithreaded)
+//   driveStatic(dut)              inputs that never change during a run
+//   drive(dut, bus, ports, mask, pcs, fetch)   memory inputs for the next
+//                                 eval; returns true if any of them changed
+//   fetchThread(dut, fetch)       thread whose barrel slot is fetched
+//   memWrite(dut)                 the store presented this cycle
+//   retirement(dut, event)        the instruction retiring this cycle, if any
+//   traceFlags(options)           trace::FileHeader flags
+//   traceReset(dut, record)       optional record for a reset cycle
+//   traceCycle(dut, options, fetch, write, record)   per-cycle record,
+//                                 except pc_delta, which is filled here
+//
+// Thread loops are unrolled at compile time, and trace logging, retirement
+// observation (--stats and what builds on it) and --cosim are template
+// parameters of the cycle loop, so a disabled hot-path feature costs no branch
+// per cycle. The rarer features stay runtime decisions to keep the number of
+// loop instantiations down: --coverage and --profile ride on the observing
+// loop, --checkpoint-at splits the loop in two, and --wave and --hang-cycles
+// are one loop-invariant branch each.
+//
+// A cycle drives the memory inputs at the low phase, evaluates, and drives
+// them once more for addresses that moved with the new inputs; the rising
+// edge's eval settles any such change before the registers sample it. PCs
+// are registers, so they are captured once, after the edge.
+
+constexpr uint32_t kSimMemBase = 0x80000000u;
+constexpr uint32_t kSimMemSize = 16 * 1024 * 1024;
+
+// One store presented by the core: mask bit i writes byte lane i.
+struct MemWrite {
+  uint32_t addr = 0;
+  uint32_t data = 0;
+  uint32_t mask = 0;
+};
+
+// A memory read port that re-reads RAM only when its address moves or a
+// store may have changed the word it holds. Device registers are read every
+// time.
+class ReadPort {
+ public:
+  uint32_t read(GuestBus& bus, uint32_t addr) {
+    if (!bus.isRam(addr)) {
+      return bus.read32(addr);
+    }
+    if (!valid_ || addr != addr_) {
+      value_ = bus.ram().read32(addr);
+      addr_ = addr;
+      valid_ = true;
+    }
+    return value_;
+  }
+
+  void invalidate() { valid_ = false; }
+
+ private:
+  bool valid_ = false;
+  uint32_t addr_ = 0;
+  uint32_t value_ = 0;
+};
+
+struct ReadPorts {
+  ReadPort instr;
+  ReadPort data;
+
+  void invalidate() {
+    instr.invalidate();
+    data.invalidate();
+  }
+};
+
+// Assigns `value` to an input port; returns true if that changed it.
+template <typename Port, typename Value>
+bool driveInput(Port& port, Value value) {
+  if (port == value) {
+    return false;
+  }
+  port = value;
+  return true;
+}
+
+template <typename Traits>
+using ThreadPcs = std::array<uint32_t, Traits::kNumThreads>;
+
+// Harness-side state saved in checkpoints next to the model and memory.
+template <typename Traits>
+struct HarnessState {
+  ThreadPcs<Traits> thread_pcs;
+  typename Traits::FetchState fetch;
+  uint32_t tohost_value;
+};
+
+namespace sim_detail {
+template <typename Fn, int... kThreads>
+void unrollThreads(Fn& fn, std::integer_sequence<int, kThreads...>) {
+  (fn(std::integral_constant<int, kThreads>{}), ...);
+}
+}  // namespace sim_detail
+
+// Calls fn(std::integral_constant<int, T>{}) for T = 0 .. N-1, unrolled at
+// compile time.
+template <int N, typename Fn>
+void forEachThread(Fn&& fn) {
+  sim_detail::unrollThreads(fn, std::make_integer_sequence<int, N>{});
+}
+
+namespace sim_detail {
+
+constexpr int kResetCycles = 5;
+
+template <bool kTraceOn, bool kStatsOn, bool kCosimOn>
+struct LoopPolicy {
+  static constexpr bool kTrace = kTraceOn;
+  static constexpr bool kStats = kStatsOn;
+  static constexpr bool kCosim = kCosimOn;
+  static constexpr bool kObserve = kStats || kCosim;
+};
+
+// Calls fn(std::true_type{}) or fn(std::false_type{}) depending on `flag`.
+template <typename Fn>
+int withFlag(bool flag, Fn&& fn) {
+  return flag ? fn(std::true_type{}) : fn(std::false_type{});
+}
+
+template <typename Traits>
+using Wave = WaveCapture<typename Traits::Model>;
+
+// Optional collectors for one run; null when their option is off.
+template <typename Traits>
+struct RunHooks {
+  Coverage* coverage = nullptr;
+  Profiler* profiler = nullptr;
+  Wave<Traits>* wave = nullptr;
+  // The --wave-before-fail rerun: the console is discarded, HTIF denies host
+  // I/O and no signature is written, so only the wave file is produced.
+  bool replay = false;
+};
+
+// Everything one test's cycle loop works on.
+template <typename Traits>
+struct TestRun {
+  typename Traits::Model& dut;
+  Memory& memory;
+  GuestBus& bus;
+  const SimOptions& options;
+  const BatchEntry& test;
+  const ElfSymbols& symbols;
+  HarnessState<Traits>& state;
+  TraceSink<typename Traits::Record>& log;
+  Cosim* cosim;
+  RunStats& stats;
+  RunHooks<Traits> hooks;
+  ReadPorts ports{};
+  bool completed = false;
+  Htif* htif = nullptr;                // single-program runs
+  ThreadPrograms* programs = nullptr;  // --thread-elf
+  bool booting = false;                // a thread is still in its boot stub
+  ThreadPcs<Traits> boot_pcs{};        // fetch PCs while booting
+};
+
+// Thread enables and the core's other constant inputs, driven once per run.
+template <typename Traits>
+void driveStatic(TestRun<Traits>& run) {
+  if constexpr (Traits::kNumThreads > 1) {
+    const uint32_t mask = run.options.thread_mask;
+    forEachThread<Traits::kNumThreads>([&](auto t) {
+      Traits::template threadEnable<decltype(t)::value>(run.dut) = (mask >> t) & 0x1;
+    });
+  }
+  Traits::driveStatic(run.dut);
+}
+
+template <typename Traits>
+bool driveInputs(TestRun<Traits>& run) {
+  if (run.booting) {
+    run.programs->bootPcs(run.state.thread_pcs.data(), run.boot_pcs.data());
+    return Traits::drive(run.dut, run.bus, run.ports, run.options.thread_mask, run.boot_pcs,
+                         run.state.fetch);
+  }
+  return Traits::drive(run.dut, run.bus, run.ports, run.options.thread_mask,
+                       run.state.thread_pcs, run.state.fetch);
+}
+
+template <typename Traits>
+void capturePcs(TestRun<Traits>& run) {
+  forEachThread<Traits::kNumThreads>([&](auto t) {
+    run.state.thread_pcs[t] = Traits::template pc<decltype(t)::value>(run.dut);
+  });
+  if (run.booting) {
+    run.programs->observePcs(run.state.thread_pcs.data());
+    run.booting = run.programs->booting();
+  }
+}
+
+// Feeds retirements to --stats, --cosim, --coverage and --profile.
+template <typename Policy, int kNumThreads>
+class RetireObserver {
+ public:
+  RetireObserver(Cosim* cosim, RunStats& stats, Coverage* coverage, Profiler* profiler)
+      : cosim_(cosim), stats_(stats), coverage_(coverage), profiler_(profiler) {}
+
+  // Returns false, after reporting it, on a co-simulation mismatch.
+  bool retire(uint64_t cycle, const RetireEvent& event) {
+    retired_ = true;
+    if constexpr (Policy::kStats) {
+      count(event);
+    }
+    if (coverage_ != nullptr) {
+      coverage_->retire(event.thread, event.pc, event.instr);
+    }
+    if (profiler_ != nullptr) {
+      profiler_->retire(event.thread, event.pc, event.instr);
+    }
+    if constexpr (Policy::kCosim) {
+      if (!cosim_->retire(cycle, event)) {
+        std::cerr << "Co-simulation mismatch: " << cosim_->mismatch() << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Closes one cycle; a cycle that retired nothing is a stall cycle.
+  void endCycle() {
+    if constexpr (Policy::kStats) {
+      ++stats_.cycles;
+      if (!retired_) {
+        ++stats_.stall_cycles;
+      }
+    }
+    retired_ = false;
+  }
+
+ private:
+  // Control-flow and load counts are derived from the architectural retire
+  // stream, so they mean the same thing on every core. ZeroNyte exports no
+  // taken signal, so a branch counts as taken when the thread's next
+  // retirement is not at pc + 4; a thread's last branch is never counted.
+  void count(const RetireEvent& event) {
+    ThreadStats& thread = stats_.threads[event.thread];
+    Last& last = last_[event.thread];
+    if (last.valid && (last.instr & 0x7f) == 0x63 && event.pc != last.pc + 4) {
+      ++thread.branches_taken;
+    }
+    const uint32_t opcode = event.instr & 0x7f;
+    thread.jal += opcode == 0x6f;
+    thread.jalr += opcode == 0x67;
+    stats_.mem_reads += opcode == 0x03;
+    ++thread.retired;
+    last = {true, event.pc, event.instr};
+  }
+
+  struct Last {
+    bool valid = false;
+    uint32_t pc = 0;
+    uint32_t instr = 0;
+  };
+
+  Cosim* cosim_;
+  RunStats& stats_;
+  Coverage* coverage_;
+  Profiler* profiler_;
+  bool retired_ = false;
+  std::array<Last, kNumThreads> last_{};
+};
+
+// Runs cycles from `start_cycle` until the test writes tohost or hits its
+// cycle limit. Returns 0 when the loop ran out (run.completed tells which),
+// otherwise the harness exit code of the failure.
+template <typename Traits, typename Policy>
+int runCycles(TestRun<Traits>& run, uint64_t start_cycle, uint64_t& cycles) {
+  auto& dut = run.dut;
+  const SimOptions& options = run.options;
+  RetireObserver<Policy, Traits::kNumThreads> observer(run.cosim, run.stats, run.hooks.coverage,
+                                                       run.hooks.profiler);
+  const std::string checkpoint_path =
+      options.checkpoint_file.empty() ? run.test.signature + ".ckpt" : options.checkpoint_file;
+
+  const bool hang_on = options.hang_cycles != 0;
+  HangDetector hang(options.hang_cycles, Traits::kNumThreads, options.thread_mask, kSimMemBase,
+                    kSimMemSize);
+  if (hang_on) {
+    hang.start(start_cycle, run.state.thread_pcs.data());
+  }
+  Wave<Traits>* const wave = run.hooks.wave;
+
+  auto observe = [&](uint64_t cycle) {
+    RetireEvent event;
+    return !Traits::retirement(dut, event) || observer.retire(cycle, event);
+  };
+
+  // --checkpoint-at splits the run at its cycle, so the per-cycle loop below
+  // never tests for it.
+  const uint64_t max_cycles = run.test.max_cycles;
+  const bool checkpoint =
+      options.checkpoint_at >= start_cycle && options.checkpoint_at < max_cycles;
+  uint64_t cycle = start_cycle;
+  for (const uint64_t end : {checkpoint ? options.checkpoint_at : max_cycles, max_cycles}) {
+    if (checkpoint && cycle == options.checkpoint_at) {
+      try {
+        if (run.htif->hasOpenFiles()) {
+          throw std::runtime_error("the guest has host files open, which are not saved");
+        }
+        saveCheckpoint(checkpoint_path, Traits::kName, cycle, options.thread_mask, run.symbols,
+                       run.state, run.memory, dut);
+      } catch (const std::exception& e) {
+        std::cerr << "Checkpoint failed: " << e.what() << std::endl;
+        return 6;
+      }
+    }
+    for (; cycle < end; ++cycle) {
+      cycles = cycle + 1;
+      dut.clock = 0;
+      driveInputs(run);
+      dut.eval();
+      [[maybe_unused]] const bool moved = driveInputs(run);
+
+      if constexpr (Policy::kStats && Traits::kNumThreads > 1) {
+        // drive() fed this slot a NOP if its thread is disabled.
+        const unsigned ft = Traits::fetchThread(dut, run.state.fetch);
+        if (!((options.thread_mask >> ft) & 0x1)) {
+          ++run.stats.threads[ft].wasted_slots;
+        }
+      }
+      if constexpr (Policy::kObserve && Traits::kRetireAtLowPhase) {
+        if (moved) {
+          // Settle so load data matches this instruction's address before the
+          // result is sampled.
+          dut.eval();
+        }
+        if (!observe(cycle)) {
+          return 7;
+        }
+      }
+
+      if (wave != nullptr) {
+        wave->dump(cycle, 0);
+      }
+
+      dut.clock = 1;
+      dut.eval();
+      capturePcs(run);
+
+      const MemWrite write = Traits::memWrite(dut);
+      if (write.mask != 0) {
+        run.ports.invalidate();
+        bool to_memory = false;
+        try {
+          to_memory = run.bus.store(write.addr, write.data, write.mask);
+        } catch (const std::exception& e) {
+          std::cerr << "Memory write failed at 0x" << std::hex << write.addr << ": " << e.what()
+                    << std::dec << std::endl;
+          return 2;
+        }
+        // Device register stores never complete the test.
+        if (to_memory && run.programs != nullptr) {
+          run.completed = run.programs->store(write.addr, write.data);
+        } else if (to_memory && write.addr == run.symbols.tohost && write.data != 0) {
+          run.completed = run.htif->store(write.data);
+          if (run.completed) {
+            run.state.tohost_value = run.htif->exitValue();
+          } else {
+            run.ports.invalidate();  // the syscall reply landed in memory
+          }
+        }
+        if constexpr (Policy::kStats) {
+          ++run.stats.mem_writes;
+        }
+      }
+
+      if (wave != nullptr) {
+        const bool pc_hit = options.wave_trigger == WaveTrigger::kPc &&
+                            run.state.thread_pcs[options.wave_thread] == options.wave_addr;
+        const bool write_hit = options.wave_trigger == WaveTrigger::kWrite && write.mask != 0 &&
+                               ((write.addr ^ options.wave_addr) & ~0x3u) == 0;
+        if (pc_hit || write_hit) {
+          wave->trigger(cycle, options.wave_cycles);
+        }
+        wave->dump(cycle, 1);
+      }
+
+      if constexpr (Policy::kTrace) {
+        typename Traits::Record record{};
+        Traits::traceCycle(dut, options, run.state.fetch, write, record);
+        for (int t = 0; t < Traits::kNumThreads; ++t) {
+          record.pc_delta[t] = run.state.thread_pcs[t];
+        }
+        run.log.cycle(cycle, record);
+      }
+
+      if constexpr (Policy::kObserve) {
+        if constexpr (!Traits::kRetireAtLowPhase) {
+          if (!observe(cycle)) {
+            return 7;
+          }
+        }
+        observer.endCycle();
+      }
+
+      if (run.completed) {
+        return 0;
+      }
+      if (hang_on && !hang.cycle(cycle, run.state.thread_pcs.data(), write.mask != 0)) {
+        std::cerr << "Hang detected: " << hang.diagnosis() << std::endl;
+        return 8;
+      }
+    }
+  }
+  return 0;
+}
+
+// Loads one ELF into a cleared memory and resets the DUT, or resumes from
+// --restore, then runs it to completion. Returns the harness exit code;
+// `cycles` receives the number of post-reset cycles simulated, counting those
+// before a restored checkpoint. `stats` is filled in when --stats is given, and
+// the `hooks` that are set follow the run.
+template <typename Traits>
+int simulate(typename Traits::Model& dut, Memory& memory, const SimOptions& options,
+             const BatchEntry& test, TraceSink<typename Traits::Record>& log, RunStats& stats,
+             const RunHooks<Traits>& hooks, uint64_t& cycles) {
+  using Record = typename Traits::Record;
+  static_assert(sizeof(Record::pc_delta) / sizeof(Record::pc_delta[0]) == Traits::kNumThreads,
+                "trace record must carry one PC per thread");
+  cycles = 0;
+
+  memory.clear();
+  ElfSymbols symbols;
+  HarnessState<Traits> state{};
+  uint64_t start_cycle = 0;
+
+  std::unique_ptr<ThreadPrograms> programs;
+  if (!options.thread_elfs.empty()) {
+    try {
+      programs = std::make_unique<ThreadPrograms>(options.thread_elfs, Traits::kNumThreads,
+                                                  kSimMemBase, memory, options.image_cache);
+    } catch (const std::exception& e) {
+      std::cerr << "ELF load failed: " << e.what() << std::endl;
+      return 1;
+    }
+    symbols = programs->firstSymbols();
+  } else if (options.restore.empty()) {
+    try {
+      loadElfIntoMemory(test.elf, memory, symbols, options.image_cache);
+    } catch (const std::exception& e) {
+      std::cerr << "ELF load failed: " << e.what() << std::endl;
+      return 1;
+    }
+  } else {
+    try {
+      start_cycle = restoreCheckpoint(options.restore, Traits::kName, options.thread_mask, symbols,
+                                      state, memory, dut);
+    } catch (const std::exception& e) {
+      std::cerr << "Checkpoint restore failed: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  std::optional<std::vector<uint32_t>> expected;
+  if (!test.expect_signature.empty()) {
+    try {
+      expected = readSignature(test.expect_signature);
+    } catch (const std::exception& e) {
+      std::cerr << "Expected signature load failed: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  std::unique_ptr<Cosim> cosim;
+  if (options.cosim) {
+    cosim = std::make_unique<Cosim>(kSimMemBase, kSimMemSize, Traits::kNumThreads);
+    cosim->reset(memory, kSimMemBase);
+  }
+
+  try {
+    log.open(test.log, test.signature, options.flight_recorder,
+             trace::makeHeader(Traits::kTraceCore, Traits::kNumThreads, Traits::traceFlags(options),
+                               sizeof(Record), symbols.tohost));
+  } catch (const std::exception& e) {
+    std::cerr << "Trace open failed: " << e.what() << std::endl;
+    return 1;
+  }
+
+  for (int t = 0; t < Traits::kNumThreads; ++t) {
+    stats.threads[t].enabled = (options.thread_mask >> t) & 0x1;
+  }
+
+  GuestConsole console = hooks.replay          ? GuestConsole::discarding()
+                         : options.batch.empty() ? GuestConsole()
+                                                 : GuestConsole(test.signature + ".console");
+  GuestBus bus(memory);
+  if (options.mmio) {
+    mapStandardDevices(bus, Traits::kNumThreads, cycles, stats, console);
+  }
+  Htif htif(memory, symbols.tohost, symbols.fromhost, console,
+            cosim != nullptr ? &cosim->memory() : nullptr, !hooks.replay);
+
+  TestRun<Traits> run{dut,   memory, bus,         options, test, symbols,
+                      state, log,    cosim.get(), stats,   hooks};
+  run.htif = &htif;
+  run.programs = programs.get();
+  run.booting = programs != nullptr && programs->booting();
+  driveStatic(run);
+
+  if (options.restore.empty()) {
+    state.thread_pcs.fill(kSimMemBase);
+    dut.reset = 1;
+    capturePcs(run);
+    for (int cycle = 0; cycle < kResetCycles; ++cycle) {
+      dut.clock = 0;
+      driveInputs(run);
+      dut.eval();
+      if (log.enabled()) {
+        Record record{};
+        if (Traits::traceReset(dut, record)) {
+          log.event(record);
+        }
+      }
+      driveInputs(run);
+      dut.clock = 1;
+      dut.eval();
+      capturePcs(run);
+    }
+    dut.reset = 0;
+  }
+
+  const int loop_exit = withFlag(log.enabled(), [&](auto trace_on) {
+    // The observing loop also feeds --coverage, --profile and --mmio's
+    // instret counter, which reads the retirements counted for --stats.
+    const bool observe = !options.stats.empty() || options.mmio || hooks.coverage != nullptr ||
+                         hooks.profiler != nullptr;
+    return withFlag(observe, [&](auto stats_on) {
+      return withFlag(cosim != nullptr, [&](auto cosim_on) {
+        using Policy = LoopPolicy<decltype(trace_on)::value, decltype(stats_on)::value,
+                                  decltype(cosim_on)::value>;
+        return runCycles<Traits, Policy>(run, start_cycle, cycles);
+      });
+    });
+  });
+  if (loop_exit == 7 && !hooks.replay) {
+    // Still dump the signature on a --cosim mismatch: RISCOF runs with --cosim
+    // and compares the signature whatever the exit code.
+    try {
+      writeSignature(memory, symbols.begin_signature, symbols.end_signature, test.signature,
+                     options.binary_signature);
+    } catch (const std::exception& e) {
+      std::cerr << "Signature dump failed: " << e.what() << std::endl;
+    }
+  }
+  if (loop_exit != 0) {
+    return loop_exit;
+  }
+
+  if (!run.completed) {
+    std::cerr << "Simulation terminated: max cycles reached" << std::endl;
+    return 3;
+  }
+
+  if (hooks.replay) {
+    return 0;  // the first run already reported the result
+  }
+  if (programs != nullptr) {
+    return programs->finish(memory, test.signature, options.binary_signature);
+  }
+
+  const uint32_t tohost_value = state.tohost_value;
+  if (tohost_value != 1) {
+    std::cerr << "Test reported failure, tohost=0x" << std::hex << tohost_value << std::dec;
+    if ((tohost_value & 0x1u) != 0) {
+      std::cerr << " (exit code " << (tohost_value >> 1) << ")";
+    }
+    std::cerr << std::endl;
+  }
+
+  std::string mismatch;
+  const bool matched = !expected || compareSignature(memory, symbols.begin_signature,
+                                                     symbols.end_signature, *expected, mismatch);
+  if (!expected || !matched || tohost_value != 1) {
+    try {
+      writeSignature(memory, symbols.begin_signature, symbols.end_signature, test.signature,
+                     options.binary_signature);
+    } catch (const std::exception& e) {
+      std::cerr << "Signature dump failed: " << e.what() << std::endl;
+      return 4;
+    }
+  }
+
+  if (tohost_value != 1) {
+    return 5;
+  }
+  if (!matched) {
+    std::cerr << "Signature mismatch at " << mismatch << std::endl;
+    return 9;
+  }
+  return 0;
+}
+
+template <typename Traits>
+int runTest(typename Traits::Model& dut, Memory& memory, const SimOptions& options,
+            const BatchEntry& test, RunStats& stats, const RunHooks<Traits>& hooks,
+            uint64_t& cycles) {
+  TraceSink<typename Traits::Record> log;
+  const int exit_code = simulate<Traits>(dut, memory, options, test, log, stats, hooks, cycles);
+  log.finish(exit_code);
+  return exit_code;
+}
+
+// One simulator instance: a private Verilator context, the model and its
+// memory. --sim-threads sizes the context's thread pool and --wave enables
+// tracing, both of which must happen before the model is constructed.
+template <typename Traits>
+struct SimInstance {
+  explicit SimInstance(unsigned sim_threads, bool wave = false) {
+    if (sim_threads != 0) {
+      context.threads(sim_threads);
+    }
+    if (wave) {
+      context.traceEverOn(true);
+    }
+    dut = std::make_unique<typename Traits::Model>(&context);
+  }
+
+  VerilatedContext context;
+  std::unique_ptr<typename Traits::Model> dut;
+  Memory memory{kSimMemBase, kSimMemSize};
+};
+
+template <typename Traits>
+std::unique_ptr<Coverage> makeCoverage(const SimOptions& options) {
+  if (options.coverage.empty()) {
+    return nullptr;
+  }
+  return std::make_unique<Coverage>(Traits::kName, Traits::kNumThreads, kSimMemBase, kSimMemSize);
+}
+
+// Indexes the functions of the --elf or --thread-elf programs for --profile.
+// Throws std::runtime_error if an ELF cannot be read.
+template <typename Traits>
+std::unique_ptr<Profiler> makeProfiler(const SimOptions& options) {
+  if (options.profile.empty()) {
+    return nullptr;
+  }
+  ElfSymbolIndex index;
+  if (options.thread_elfs.empty()) {
+    index = loadElfSymbolIndex(options.elf);
+  }
+  for (const ThreadElf& thread_elf : options.thread_elfs) {
+    index.add(loadElfSymbolIndex(thread_elf.path));
+  }
+  return std::make_unique<Profiler>(std::move(index), Traits::kNumThreads);
+}
+
+// Runs `save`, which writes one of the run's output files; a failure is
+// reported as "<what> write failed" and turns a passing exit code into 1.
+template <typename Save>
+int saveOutput(const char* what, Save&& save, int exit_code) {
+  try {
+    save();
+  } catch (const std::exception& e) {
+    std::cerr << what << " write failed: " << e.what() << std::endl;
+    return exit_code == 0 ? 1 : exit_code;
+  }
+  return exit_code;
+}
+
+inline int saveCoverage(const Coverage& coverage, const std::string& path, int exit_code) {
+  return saveOutput("Coverage", [&] { coverage.save(path); }, exit_code);
+}
+
+// The --wave capture for the first run: the whole run, the --wave-window, or
+// an unopened window for the PC and store triggers. --wave-before-fail
+// captures nothing until a failure is known, so it gets none.
+template <typename Traits>
+std::unique_ptr<Wave<Traits>> makeWave(typename Traits::Model& dut, const SimOptions& options) {
+  using Capture = Wave<Traits>;
+  switch (options.wave_trigger) {
+    case WaveTrigger::kAlways:
+      return std::make_unique<Capture>(dut, options.wave, 0, Capture::kNever);
+    case WaveTrigger::kWindow:
+      return std::make_unique<Capture>(dut, options.wave, options.wave_from, options.wave_to);
+    case WaveTrigger::kPc:
+    case WaveTrigger::kWrite:
+      return std::make_unique<Capture>(dut, options.wave, Capture::kNever, Capture::kNever);
+    case WaveTrigger::kFailure:
+      break;
+  }
+  return nullptr;
+}
+
+// --wave-before-fail: the failing test is run again from the start with the
+// window set to the `cycles` before it ended. The rerun writes no trace,
+// signature, checkpoint or console output and gets no host I/O; a guest that
+// depends on host input may therefore diverge, which is reported.
+template <typename Traits>
+void captureFailureWave(SimInstance<Traits>& sim, const SimOptions& options,
+                        const BatchEntry& test, uint64_t cycles) {
+  const uint64_t from = cycles > options.wave_cycles ? cycles - options.wave_cycles : 0;
+  std::cerr << "Re-running to capture cycles " << from << ".." << cycles << " in "
+            << options.wave << std::endl;
+  SimOptions rerun_options = options;
+  rerun_options.flight_recorder = 0;
+  rerun_options.checkpoint_at = std::numeric_limits<uint64_t>::max();
+  BatchEntry rerun_test = test;
+  rerun_test.log.clear();
+  rerun_test.signature.clear();
+  try {
+    Wave<Traits> wave(*sim.dut, options.wave, from, cycles);
+    RunStats stats(Traits::kNumThreads);
+    RunHooks<Traits> hooks;
+    hooks.wave = &wave;
+    hooks.replay = true;
+    uint64_t rerun_cycles = 0;
+    runTest<Traits>(*sim.dut, sim.memory, rerun_options, rerun_test, stats, hooks,
+                    rerun_cycles);
+    if (rerun_cycles != cycles) {
+      std::cerr << "Warning: the rerun ended at cycle " << rerun_cycles << ", not " << cycles
+                << "; " << options.wave << " may not show the failure" << std::endl;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Wave capture failed: " << e.what() << std::endl;
+  }
+}
+
+}  // namespace sim_detail
+
+// The whole harness: parses arguments, then runs one test or a --batch
+// manifest. Returns the process exit code.
+template <typename Traits>
+int simMain(int argc, char** argv) {
+  using Instance = sim_detail::SimInstance<Traits>;
+  Verilated::commandArgs(argc, argv);
+
+  SimOptions options;
+  std::vector<BatchEntry> tests;
+  try {
+    options = parseSimOptions(argc, argv, Traits::kNumThreads, Traits::kTraceDetailFlag);
+    if (!options.sim_affinity.empty()) {
+      pinToCpus(options.sim_affinity);
+    }
+    if (options.batch.empty()) {
+      tests.push_back({options.elf, options.signature, options.max_cycles, options.log,
+                       options.expect_signature});
+    } else {
+      tests = loadBatchManifest(options.batch, options.max_cycles);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Argument error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  if (options.flight_recorder != 0) {
+    installFlightRecorderSignalHandlers();
+  }
+
+  if (options.batch.empty()) {
+    Instance sim(options.sim_threads, !options.wave.empty());
+    sim.context.commandArgs(argc, argv);
+    uint64_t cycles = 0;
+    RunStats stats(Traits::kNumThreads);
+    const std::unique_ptr<Coverage> coverage = sim_detail::makeCoverage<Traits>(options);
+    std::unique_ptr<Profiler> profiler;
+    try {
+      profiler = sim_detail::makeProfiler<Traits>(options);
+    } catch (const std::exception& e) {
+      std::cerr << "Profile symbol load failed: " << e.what() << std::endl;
+      return 1;
+    }
+    std::unique_ptr<sim_detail::Wave<Traits>> wave;
+    if (!options.wave.empty()) {
+      try {
+        wave = sim_detail::makeWave<Traits>(*sim.dut, options);
+      } catch (const std::exception& e) {
+        std::cerr << "Wave open failed: " << e.what() << std::endl;
+        return 1;
+      }
+    }
+    const sim_detail::RunHooks<Traits> hooks{coverage.get(), profiler.get(), wave.get()};
+    int exit_code =
+        sim_detail::runTest<Traits>(*sim.dut, sim.memory, options, tests.front(), stats, hooks,
+                                    cycles);
+    if (wave != nullptr) {
+      wave->close();
+      if (!wave->captured()) {
+        std::cerr << "Warning: the --wave trigger never fired; " << options.wave << " is empty"
+                  << std::endl;
+      }
+    } else if (options.wave_trigger == WaveTrigger::kFailure && exit_code != 0 &&
+               exit_code != 1) {
+      sim_detail::captureFailureWave<Traits>(sim, options, tests.front(), cycles);
+    }
+    if (coverage != nullptr) {
+      exit_code = sim_detail::saveCoverage(*coverage, options.coverage, exit_code);
+    }
+    if (profiler != nullptr) {
+      exit_code = sim_detail::saveOutput(
+          "Profile", [&] { profiler->write(options.profile, Traits::kName); }, exit_code);
+    }
+    if (options.stats.empty()) {
+      return exit_code;
+    }
+    return saveStats(options.stats,
+                     {formatStatsJson(Traits::kName, tests.front().elf, exit_code, stats)}, false,
+                     exit_code);
+  }
+
+  // Batch mode: each worker thread owns a private SimInstance and resets the
+  // model between the tests it pulls from the shared queue. Each test's
+  // --stats object lands in its manifest slot, and its --coverage is written
+  // next to its signature and merged into the batch total.
+  std::vector<std::string> stats_json(tests.size());
+  const std::unique_ptr<Coverage> total_coverage = sim_detail::makeCoverage<Traits>(options);
+  std::mutex coverage_mutex;
+  int exit_code = runBatch(
+      tests, options.jobs, [&] { return std::make_unique<Instance>(options.sim_threads); },
+      [&](Instance& sim, const BatchEntry& test, uint64_t& cycles) {
+        RunStats stats(Traits::kNumThreads);
+        const std::unique_ptr<Coverage> coverage = sim_detail::makeCoverage<Traits>(options);
+        sim_detail::RunHooks<Traits> hooks;
+        hooks.coverage = coverage.get();
+        int test_exit =
+            sim_detail::runTest<Traits>(*sim.dut, sim.memory, options, test, stats, hooks, cycles);
+        if (coverage != nullptr) {
+          test_exit = sim_detail::saveCoverage(*coverage, test.signature + ".cov", test_exit);
+          const std::lock_guard<std::mutex> lock(coverage_mutex);
+          total_coverage->merge(*coverage);
+        }
+        if (!options.stats.empty()) {
+          stats_json[&test - tests.data()] =
+              formatStatsJson(Traits::kName, test.elf, test_exit, stats);
+        }
+        return test_exit;
+      });
+  if (total_coverage != nullptr) {
+    exit_code = sim_detail::saveCoverage(*total_coverage, options.coverage, exit_code);
+  }
+  if (options.stats.empty()) {
+    return exit_code;
+  }
+  return saveStats(options.stats, stats_json, true, exit_code);
+}
@@ -0,0 +1,192 @@
+#include "sim_options.h"
+
+#include <stdexcept>
+
+namespace {
+
+// Parses N=<path> for a core with `num_threads` threads.
+ThreadElf parseThreadElf(const std::string& arg, int num_threads) {
+  const size_t eq = arg.find('=');
+  if (eq == 0 || eq == std::string::npos || eq + 1 == arg.size()) {
+    throw std::invalid_argument("--thread-elf expects N=<path>, got " + arg);
+  }
+  const unsigned long thread = std::stoul(arg.substr(0, eq));
+  if (thread >= static_cast<unsigned long>(num_threads)) {
+    throw std::invalid_argument("--thread-elf thread " + arg.substr(0, eq) + " out of range");
+  }
+  return {static_cast<unsigned>(thread), arg.substr(eq + 1)};
+}
+
+// Splits A:B; `second` is set and true returned only when the colon is there.
+bool splitPair(const std::string& arg, std::string& first, std::string& second) {
+  const size_t colon = arg.find(':');
+  if (colon == std::string::npos) {
+    first = arg;
+    return false;
+  }
+  first = arg.substr(0, colon);
+  second = arg.substr(colon + 1);
+  return true;
+}
+
+void setWaveTrigger(SimOptions& opts, WaveTrigger trigger) {
+  if (opts.wave_trigger != WaveTrigger::kAlways) {
+    throw std::invalid_argument("only one --wave trigger may be given");
+  }
+  opts.wave_trigger = trigger;
+}
+
+}  // namespace
+
+SimOptions parseSimOptions(int argc, char** argv, int num_threads, const char* trace_detail_flag) {
+  const bool multithreaded = num_threads > 1;
+  SimOptions opts;
+  bool thread_mask_given = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "--elf" && i + 1 < argc) {
+      opts.elf = argv[++i];
+    } else if (arg == "--signature" && i + 1 < argc) {
+      opts.signature = argv[++i];
+    } else if (arg == "--expect-signature" && i + 1 < argc) {
+      opts.expect_signature = argv[++i];
+    } else if (arg == "--signature-format" && i + 1 < argc) {
+      const std::string format(argv[++i]);
+      if (format != "hex" && format != "bin") {
+        throw std::invalid_argument("--signature-format must be hex or bin");
+      }
+      opts.binary_signature = format == "bin";
+    } else if (arg == "--log" && i + 1 < argc) {
+      opts.log = argv[++i];
+    } else if (arg == "--image-cache" && i + 1 < argc) {
+      opts.image_cache = argv[++i];
+    } else if (arg == "--batch" && i + 1 < argc) {
+      opts.batch = argv[++i];
+    } else if (arg == "--jobs" && i + 1 < argc) {
+      opts.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else if (multithreaded && arg == "--sim-threads" && i + 1 < argc) {
+      opts.sim_threads = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else if (multithreaded && arg == "--sim-affinity" && i + 1 < argc) {
+      opts.sim_affinity = argv[++i];
+    } else if (arg == "--checkpoint-at" && i + 1 < argc) {
+      opts.checkpoint_at = std::stoull(argv[++i]);
+    } else if (arg == "--checkpoint-file" && i + 1 < argc) {
+      opts.checkpoint_file = argv[++i];
+    } else if (arg == "--restore" && i + 1 < argc) {
+      opts.restore = argv[++i];
+    } else if (arg == "--stats" && i + 1 < argc) {
+      opts.stats = argv[++i];
+    } else if (arg == "--coverage" && i + 1 < argc) {
+      opts.coverage = argv[++i];
+    } else if (arg == "--profile" && i + 1 < argc) {
+      opts.profile = argv[++i];
+    } else if (arg == "--wave" && i + 1 < argc) {
+      opts.wave = argv[++i];
+    } else if (arg == "--wave-window" && i + 1 < argc) {
+      setWaveTrigger(opts, WaveTrigger::kWindow);
+      std::string from, to;
+      if (!splitPair(argv[++i], from, to)) {
+        throw std::invalid_argument("--wave-window expects FROM:TO");
+      }
+      opts.wave_from = std::stoull(from);
+      opts.wave_to = std::stoull(to);
+      if (opts.wave_to <= opts.wave_from) {
+        throw std::invalid_argument("--wave-window is empty");
+      }
+    } else if (arg == "--wave-on-pc" && i + 1 < argc) {
+      setWaveTrigger(opts, WaveTrigger::kPc);
+      std::string thread, pc;
+      if (splitPair(argv[++i], thread, pc)) {
+        opts.wave_thread = static_cast<unsigned>(std::stoul(thread));
+      } else {
+        pc = thread;
+      }
+      if (opts.wave_thread >= static_cast<unsigned>(num_threads)) {
+        throw std::invalid_argument("--wave-on-pc thread " + thread + " out of range");
+      }
+      opts.wave_addr = static_cast<uint32_t>(std::stoul(pc, nullptr, 0));
+    } else if (arg == "--wave-on-write" && i + 1 < argc) {
+      setWaveTrigger(opts, WaveTrigger::kWrite);
+      opts.wave_addr = static_cast<uint32_t>(std::stoul(argv[++i], nullptr, 0));
+    } else if (arg == "--wave-before-fail" && i + 1 < argc) {
+      setWaveTrigger(opts, WaveTrigger::kFailure);
+      opts.wave_cycles = std::stoull(argv[++i]);
+    } else if (arg == "--wave-cycles" && i + 1 < argc) {
+      opts.wave_cycles = std::stoull(argv[++i]);
+    } else if (arg == "--cosim") {
+      opts.cosim = true;
+    } else if (arg == "--mmio") {
+      opts.mmio = true;
+    } else if (arg == "--flight-recorder" && i + 1 < argc) {
+      opts.flight_recorder = std::stoull(argv[++i]);
+    } else if (arg == "--max-cycles" && i + 1 < argc) {
+      opts.max_cycles = std::stoull(argv[++i]);
+    } else if (arg == "--hang-cycles" && i + 1 < argc) {
+      opts.hang_cycles = std::stoull(argv[++i]);
+    } else if (multithreaded && arg == "--thread-mask" && i + 1 < argc) {
+      opts.thread_mask = static_cast<uint32_t>(std::stoul(argv[++i], nullptr, 0));
+      thread_mask_given = true;
+    } else if (multithreaded && arg == "--thread-elf" && i + 1 < argc) {
+      opts.thread_elfs.push_back(parseThreadElf(argv[++i], num_threads));
+    } else if (trace_detail_flag != nullptr && arg == trace_detail_flag) {
+      opts.trace_detail = true;
+    } else if (arg.rfind("+", 0) == 0) {
+      // Verilator runtime plusarg (e.g. +verilator+seed+N), handled by commandArgs.
+    } else {
+      throw std::invalid_argument("unknown or incomplete argument: " + arg);
+    }
+  }
+  if (!opts.thread_elfs.empty()) {
+    if (!opts.elf.empty() || !opts.batch.empty() || !opts.restore.empty() || thread_mask_given) {
+      throw std::invalid_argument(
+          "--thread-elf cannot be combined with --elf, --batch, --restore or --thread-mask");
+    }
+    if (opts.cosim || opts.checkpoint_at != std::numeric_limits<uint64_t>::max() ||
+        !opts.expect_signature.empty()) {
+      throw std::invalid_argument(
+          "--thread-elf does not support --cosim, --checkpoint-at or --expect-signature");
+    }
+    opts.thread_mask = 0;
+    for (const ThreadElf& thread_elf : opts.thread_elfs) {
+      if ((opts.thread_mask >> thread_elf.thread) & 0x1) {
+        throw std::invalid_argument("--thread-elf given twice for thread " +
+                                    std::to_string(thread_elf.thread));
+      }
+      opts.thread_mask |= 1u << thread_elf.thread;
+    }
+  }
+  if (opts.batch.empty() &&
+      ((opts.elf.empty() && opts.restore.empty() && opts.thread_elfs.empty()) ||
+       opts.signature.empty())) {
+    throw std::invalid_argument("--elf (or --restore or --thread-elf) and --signature are required");
+  }
+  if (!opts.batch.empty() && !opts.expect_signature.empty()) {
+    throw std::invalid_argument(
+        "--expect-signature applies to a single test; give references in the --batch manifest");
+  }
+  if (!opts.profile.empty() && (!opts.batch.empty() || !opts.restore.empty())) {
+    throw std::invalid_argument(
+        "--profile needs the test's ELF; use it with --elf or --thread-elf");
+  }
+  if (opts.wave.empty() && opts.wave_trigger != WaveTrigger::kAlways) {
+    throw std::invalid_argument("--wave-window, --wave-on-pc, --wave-on-write and "
+                                "--wave-before-fail need --wave <file.fst>");
+  }
+  if (!opts.wave.empty() && !opts.batch.empty()) {
+    throw std::invalid_argument("--wave captures a single test and cannot be used with --batch");
+  }
+  if (opts.cosim && opts.mmio) {
+    throw std::invalid_argument("--cosim cannot model --mmio device registers");
+  }
+  if (opts.cosim && !opts.restore.empty()) {
+    throw std::invalid_argument("--cosim cannot start from a --restore checkpoint");
+  }
+  if (!opts.restore.empty() && !opts.batch.empty()) {
+    throw std::invalid_argument(
+        "--restore resumes a single checkpointed test and cannot be used with --batch");
+  }
+  if (!opts.restore.empty() && opts.mmio) {
+    throw std::invalid_argument("--restore cannot resume --mmio device state");
+  }
+  return opts;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+// What opens the --wave window.
+enum class WaveTrigger {
+  kAlways,   // no trigger: the whole run
+  kWindow,   // --wave-window FROM:TO
+  kPc,       // --wave-on-pc [T:]PC, thread T's PC first reaching PC
+  kWrite,    // --wave-on-write ADDR, the first store to ADDR's word
+  kFailure,  // --wave-before-fail N, the last N cycles of a failing run
+};
+
+// One --thread-elf N=<path>.
+struct ThreadElf {
+  unsigned thread;
+  std::string path;
+};
+
+// Command-line options shared by every harness.
+struct SimOptions {
+  std::string elf;
+  std::string signature;
+  bool binary_signature = false;  // --signature-format bin
+  // Reference signature to check against in-process; the signature file is
+  // then written only when it differs.
+  std::string expect_signature;
+  std::string log;
+  std::string image_cache;
+  std::string batch;
+  unsigned jobs = 1;
+  size_t flight_recorder = 0;  // cycles kept for the failure dump; 0 = off
+  uint64_t checkpoint_at = std::numeric_limits<uint64_t>::max();  // max = never
+  std::string checkpoint_file;  // default: <signature>.ckpt
+  std::string restore;
+  bool cosim = false;  // check every retirement against the built-in ISS
+  // Map the console, timer and counter devices (see guest_bus.h). Console
+  // output goes to stdout, or to <signature>.console in --batch.
+  bool mmio = false;
+  std::string stats;   // JSON counters; an array with one object per test in --batch
+  // PC/opcode coverage; in --batch each test also writes <signature>.cov and
+  // this file receives the merge of all of them.
+  std::string coverage;
+  // Per-function flat profile; the folded stacks go to <profile>.folded.
+  std::string profile;
+  // FST waveform of one window of the run; see WaveTrigger.
+  std::string wave;
+  WaveTrigger wave_trigger = WaveTrigger::kAlways;
+  uint64_t wave_from = 0;  // kWindow: cycles [wave_from, wave_to)
+  uint64_t wave_to = std::numeric_limits<uint64_t>::max();
+  unsigned wave_thread = 0;  // kPc
+  uint32_t wave_addr = 0;    // kPc: the PC; kWrite: the store address
+  // Window length after a kPc/kWrite trigger, or before a kFailure exit.
+  uint64_t wave_cycles = 2000;
+  uint64_t max_cycles = 1'000'000;
+  // Hang detection window (--hang-cycles); 0, the default, leaves it off
+  // since the no-store rule can flag valid register-only loops.
+  uint64_t hang_cycles = 0;
+
+  // Multithreaded cores only.
+  unsigned sim_threads = 0;  // 0 = Verilator default
+  std::string sim_affinity;
+  uint32_t thread_mask = 0x1;  // bit per thread; default only thread 0 enabled
+  // A program per thread instead of --elf; enables exactly those threads.
+  std::vector<ThreadElf> thread_elfs;
+
+  // Set by the core's extra trace flag (--trace-pc, --trace-stage).
+  bool trace_detail = false;
+};
+
+// Parses argv. --thread-mask, --thread-elf, --sim-threads and --sim-affinity
+// are accepted only when `num_threads` > 1, and `trace_detail_flag` (may be null) sets
+// trace_detail. Verilator plusargs are skipped. Throws std::invalid_argument
+// on an unknown, incomplete or inconsistent argument.
+SimOptions parseSimOptions(int argc, char** argv, int num_threads, const char* trace_detail_flag);
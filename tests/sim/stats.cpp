@@ -0,0 +1,106 @@
+#include "stats.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::string jsonString(const std::string& s) {
+  std::string quoted = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      quoted += buf;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+// Writes the "ipc" and "cpi" members, separated by `sep`; CPI is null when
+// nothing retired.
+void writeRates(std::ostream& out, uint64_t retired, uint64_t cycles, const char* sep) {
+  out << "\"ipc\": " << (cycles != 0 ? static_cast<double>(retired) / cycles : 0.0) << sep
+      << "\"cpi\": ";
+  if (retired != 0) {
+    out << static_cast<double>(cycles) / retired;
+  } else {
+    out << "null";
+  }
+}
+
+}  // namespace
+
+std::string formatStatsJson(const char* core, const std::string& elf, int exit_code,
+                            const RunStats& stats) {
+  uint64_t retired = 0;
+  for (const ThreadStats& thread : stats.threads) {
+    retired += thread.retired;
+  }
+
+  std::ostringstream out;
+  out.precision(6);
+  out << "{\n"
+      << "  \"core\": " << jsonString(core) << ",\n"
+      << "  \"elf\": " << jsonString(elf) << ",\n"
+      << "  \"exit_code\": " << exit_code << ",\n"
+      << "  \"cycles\": " << stats.cycles << ",\n"
+      << "  \"retired\": " << retired << ",\n  ";
+  writeRates(out, retired, stats.cycles, ",\n  ");
+  out << ",\n"
+      << "  \"mem_reads\": " << stats.mem_reads << ",\n"
+      << "  \"mem_writes\": " << stats.mem_writes << ",\n"
+      << "  \"stall_cycles\": " << stats.stall_cycles << ",\n"
+      << "  \"threads\": [";
+  for (size_t t = 0; t < stats.threads.size(); ++t) {
+    const ThreadStats& thread = stats.threads[t];
+    out << (t == 0 ? "\n" : ",\n") << "    {\"thread\": " << t
+        << ", \"enabled\": " << (thread.enabled ? "true" : "false")
+        << ", \"retired\": " << thread.retired << ", ";
+    writeRates(out, thread.retired, stats.cycles, ", ");
+    out << ", \"wasted_slots\": " << thread.wasted_slots
+        << ", \"branches_taken\": " << thread.branches_taken << ", \"jal\": " << thread.jal
+        << ", \"jalr\": " << thread.jalr << "}";
+  }
+  out << "\n  ]\n}";
+  return out.str();
+}
+
+void writeStatsJson(const std::string& path, const std::vector<std::string>& runs, bool batch) {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    throw std::runtime_error("cannot create " + path);
+  }
+  if (batch) {
+    out << "[";
+    for (size_t i = 0; i < runs.size(); ++i) {
+      out << (i == 0 ? "\n" : ",\n") << runs[i];
+    }
+    out << "\n]\n";
+  } else if (!runs.empty()) {
+    out << runs.front() << "\n";
+  }
+  out.close();
+  if (!out) {
+    throw std::runtime_error("write failed for " + path);
+  }
+}
+
+int saveStats(const std::string& path, const std::vector<std::string>& runs, bool batch,
+              int exit_code) {
+  try {
+    writeStatsJson(path, runs, batch);
+  } catch (const std::exception& e) {
+    std::cerr << "Stats write failed: " << e.what() << std::endl;
+    return exit_code == 0 ? 1 : exit_code;
+  }
+  return exit_code;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Counters for one hardware thread.
+struct ThreadStats {
+  bool enabled = false;
+  uint64_t retired = 0;
+  uint64_t wasted_slots = 0;  // barrel fetch slots filled with a NOP while disabled
+  // Conditional branches whose next retirement on the thread was not at pc + 4.
+  // Inferred from the retire stream, so a branch the thread retires last is
+  // not counted.
+  uint64_t branches_taken = 0;
+  uint64_t jal = 0;
+  uint64_t jalr = 0;
+};
+
+// Counters for one test, gathered by the cycle loop when --stats is given.
+// Only cycles simulated by this process are counted, so a run resumed with
+// --restore reports the part after the checkpoint.
+struct RunStats {
+  explicit RunStats(size_t num_threads) : threads(num_threads) {}
+
+  uint64_t cycles = 0;
+  uint64_t mem_reads = 0;
+  uint64_t mem_writes = 0;
+  uint64_t stall_cycles = 0;  // meaning is core specific; see the harness
+  std::vector<ThreadStats> threads;
+};
+
+// Formats one test's counters, with IPC/CPI derived per thread and in total,
+// as a JSON object.
+std::string formatStatsJson(const char* core, const std::string& elf, int exit_code,
+                            const RunStats& stats);
+
+// Writes `runs` (objects from formatStatsJson) to `path`: the object itself
+// for a single run, a JSON array for a batch. Throws std::runtime_error on
+// I/O failure.
+void writeStatsJson(const std::string& path, const std::vector<std::string>& runs, bool batch);
+
+// Calls writeStatsJson and reports a failure on stderr. Returns `exit_code`,
+// or 1 when the run otherwise succeeded but the file could not be written.
+int saveStats(const std::string& path, const std::vector<std::string>& runs, bool batch,
+              int exit_code);
@@ -1,237 +1,110 @@
-#include <array>
 #include <cstdint>
-#include <fstream>
-#include <iostream>
-#include <stdexcept>
-#include <string>
+#include <tuple>
 
 #include "VTetraNyteRV32ICore.h"
-#include "elf_loader.h"
-#include "memory.h"
-#include "verilated.h"
+#include "sim_main.h"
 
 namespace {
-struct Options {
-  std::string elf;
-  std::string signature;
-  std::string log;
-  uint64_t max_cycles = 1'000'000;
-  bool trace_pc = false;
-  uint32_t thread_mask = 0x1;  // bit per thread; default only thread 0 enabled
-};
-
-Options parseArgs(int argc, char** argv) {
-  Options opts;
-  for (int i = 1; i < argc; ++i) {
-    const std::string arg(argv[i]);
-    if (arg == "--elf" && i + 1 < argc) {
-      opts.elf = argv[++i];
-    } else if (arg == "--signature" && i + 1 < argc) {
-      opts.signature = argv[++i];
-    } else if (arg == "--log" && i + 1 < argc) {
-      opts.log = argv[++i];
-    } else if (arg == "--max-cycles" && i + 1 < argc) {
-      opts.max_cycles = std::stoull(argv[++i]);
-    } else if (arg == "--thread-mask" && i + 1 < argc) {
-      opts.thread_mask = static_cast<uint32_t>(std::stoul(argv[++i], nullptr, 0));
-    } else if (arg == "--trace-pc") {
-      opts.trace_pc = true;
-    } else {
-      throw std::invalid_argument("unknown or incomplete argument: " + arg);
-    }
-  }
-  if (opts.elf.empty() || opts.signature.empty()) {
-    throw std::invalid_argument("--elf and --signature are required");
+struct TetraNyteTraits {
+  using Model = VTetraNyteRV32ICore;
+  using Record = trace::TetraNyteRecord;
+  static constexpr char kName[] = "tetranyte";
+  static constexpr trace::Core kTraceCore = trace::kTetraNyte;
+  static constexpr int kNumThreads = 4;
+  static constexpr int kFetchWidth = 1;
+  static constexpr const char* kTraceDetailFlag = "--trace-pc";
+  // The WB-stage instruction commits at the next edge; each one is visible
+  // after the rising edge for exactly one cycle.
+  static constexpr bool kRetireAtLowPhase = false;
+
+  struct FetchState {};
+
+  template <int T>
+  static uint32_t pc(const Model& dut) {
+    return std::get<T>(std::tie(dut.io_if_pc_0, dut.io_if_pc_1, dut.io_if_pc_2, dut.io_if_pc_3));
   }
-  return opts;
-}
 
-constexpr uint32_t kMemBase = 0x80000000u;
-constexpr uint32_t kMemSize = 16 * 1024 * 1024;
-constexpr int kResetCycles = 5;
-constexpr int kNumThreads = 4;
-
-void writeMasked(Memory& memory, uint32_t addr, uint32_t data, uint32_t mask) {
-  for (int byte = 0; byte < 4; ++byte) {
-    if ((mask >> byte) & 0x1) {
-      memory.write8(addr + byte, static_cast<uint8_t>((data >> (8 * byte)) & 0xFFu));
-    }
+  template <int T>
+  static CData& threadEnable(Model& dut) {
+    return std::get<T>(std::tie(dut.io_threadEnable_0, dut.io_threadEnable_1,
+                                dut.io_threadEnable_2, dut.io_threadEnable_3));
   }
-}
-
-}  // namespace
 
-int main(int argc, char** argv) {
-  Verilated::commandArgs(argc, argv);
-
-  Options options;
-  try {
-    options = parseArgs(argc, argv);
-  } catch (const std::exception& e) {
-    std::cerr << "Argument error: " << e.what() << std::endl;
-    return 1;
+  static void driveStatic(Model&) {}
+
+  // Barrel fetch: feed each thread from its own PC if enabled; otherwise feed NOP.
+  static bool drive(Model& dut, GuestBus& bus, ReadPorts& ports, uint32_t thread_mask,
+                    const ThreadPcs<TetraNyteTraits>& pcs, FetchState&) {
+    const uint32_t ft = dut.io_fetchThread & 0x3;
+    const uint32_t instr =
+        ((thread_mask >> ft) & 0x1) ? ports.instr.read(bus, pcs[ft]) : 0x00000013;  // NOP
+    const bool fetch = driveInput(dut.io_instrMem, instr);
+    const bool data = driveInput(dut.io_dataMemResp, ports.data.read(bus, dut.io_memAddr));
+    return fetch || data;
   }
 
-  std::ofstream log;
-  if (!options.log.empty()) {
-    log.open(options.log);
+  static unsigned fetchThread(const Model& dut, const FetchState&) {
+    return dut.io_fetchThread & 0x3;
   }
 
-  Memory memory(kMemBase, kMemSize);
-  ElfSymbols symbols;
-
-  try {
-    loadElfIntoMemory(options.elf, memory, symbols);
-  } catch (const std::exception& e) {
-    std::cerr << "ELF load failed: " << e.what() << std::endl;
-    return 1;
+  static MemWrite memWrite(const Model& dut) {
+    return {dut.io_memAddr, dut.io_memWrite, dut.io_memMask};
   }
 
-  VTetraNyteRV32ICore dut;
-
-  std::array<uint32_t, kNumThreads> thread_pcs{};
-  thread_pcs.fill(kMemBase);
-
-  // Apply thread mask to the DUT (bit i enables thread i)
-  auto driveThreadMask = [&]() {
-    dut.io_threadEnable_0 = (options.thread_mask >> 0) & 0x1;
-    dut.io_threadEnable_1 = (options.thread_mask >> 1) & 0x1;
-    dut.io_threadEnable_2 = (options.thread_mask >> 2) & 0x1;
-    dut.io_threadEnable_3 = (options.thread_mask >> 3) & 0x1;
-  };
-
-  auto captureThreadPcs = [&]() {
-    thread_pcs[0] = dut.io_if_pc_0;
-    thread_pcs[1] = dut.io_if_pc_1;
-    thread_pcs[2] = dut.io_if_pc_2;
-    thread_pcs[3] = dut.io_if_pc_3;
-  };
-
-  auto driveMemory = [&]() {
-    driveThreadMask();
-    // Barrel fetch: feed each thread from its own PC if enabled; otherwise feed NOP.
-    uint32_t ft = dut.io_fetchThread & 0x3;
-    if ((options.thread_mask >> ft) & 0x1) {
-      dut.io_instrMem = memory.read32(thread_pcs[ft]);
-    } else {
-      dut.io_instrMem = 0x00000013;  // NOP
-    }
-    dut.io_dataMemResp = memory.read32(dut.io_memAddr);
-  };
-
-  // Reset
-  dut.reset = 1;
-  captureThreadPcs();
-  for (int cycle = 0; cycle < kResetCycles; ++cycle) {
-    dut.clock = 0;
-    driveMemory();
-    dut.eval();
-    captureThreadPcs();
-    if (log.is_open() && dut.io_ctrlTaken) {
-      log << std::hex << "ctrl: taken=1 "
-          << "thread=" << static_cast<unsigned>(dut.io_ctrlThread)
-          << " from=0x" << dut.io_ctrlFromPC
-          << " target=0x" << dut.io_ctrlTarget
-          << " branch=" << static_cast<unsigned>(dut.io_ctrlIsBranch)
-          << " jal=" << static_cast<unsigned>(dut.io_ctrlIsJal)
-          << " jalr=" << static_cast<unsigned>(dut.io_ctrlIsJalr)
-          << std::dec << '\n';
+  static bool retirement(const Model& dut, RetireEvent& event) {
+    if (!dut.io_wbValid) {
+      return false;
     }
-    dut.clock = 1;
-    driveMemory();
-    dut.eval();
-    captureThreadPcs();
+    event.thread = dut.io_wbThread & 0x3;
+    event.pc = dut.io_wbPC;
+    event.instr = dut.io_wbInstr;
+    event.rd = dut.io_wbWrite ? dut.io_wbRd : 0;
+    event.data = dut.io_wbData;
+    return true;
   }
-  dut.reset = 0;
 
-  bool completed = false;
-  uint32_t tohost_value = 0;
-
-  for (uint64_t cycle = 0; cycle < options.max_cycles; ++cycle) {
-    dut.clock = 0;
-    driveMemory();
-    dut.eval();
-    captureThreadPcs();
-
-    dut.clock = 1;
-    driveMemory();
-    dut.eval();
-    captureThreadPcs();
-    if (log.is_open()) {
-      log << std::hex << "pcs post-eval: "
-          << "pc0=0x" << dut.io_if_pc_0 << " "
-          << "pc1=0x" << dut.io_if_pc_1 << " "
-          << "pc2=0x" << dut.io_if_pc_2 << " "
-          << "pc3=0x" << dut.io_if_pc_3
-          << " en=[" << static_cast<unsigned>(dut.io_threadEnable_0)
-          << static_cast<unsigned>(dut.io_threadEnable_1)
-          << static_cast<unsigned>(dut.io_threadEnable_2)
-          << static_cast<unsigned>(dut.io_threadEnable_3) << "]"
-          << std::dec << '\n';
-
-      if (dut.io_ctrlTaken) {
-        log << std::hex << "ctrl: taken=1 "
-            << "thread=" << static_cast<unsigned>(dut.io_ctrlThread)
-            << " from=0x" << dut.io_ctrlFromPC
-            << " target=0x" << dut.io_ctrlTarget
-            << " branch=" << static_cast<unsigned>(dut.io_ctrlIsBranch)
-            << " jal=" << static_cast<unsigned>(dut.io_ctrlIsJal)
-            << " jalr=" << static_cast<unsigned>(dut.io_ctrlIsJalr)
-            << std::dec << '\n';
-      }
-    }
-
-    const uint32_t addr = dut.io_memAddr;
-    const uint32_t data = dut.io_memWrite;
-    const uint32_t mask = dut.io_memMask;
-    if (mask != 0) {
-      writeMasked(memory, addr, data, mask);
-      if (addr == symbols.tohost && data != 0) {
-        tohost_value = data;
-        completed = true;
-      }
-    }
-
-    if (log.is_open()) {
-      log << std::hex
-          << "cycle=0x" << cycle
-          << " memAddr=0x" << addr
-          << " mask=0x" << mask
-          << " tohost=0x" << symbols.tohost;
-      if (options.trace_pc) {
-      log << " pc0=0x" << thread_pcs[0]
-          << " pc1=0x" << thread_pcs[1]
-          << " pc2=0x" << thread_pcs[2]
-          << " pc3=0x" << thread_pcs[3]
-          << " instr0=0x" << dut.io_if_instr_0
-          << " instr1=0x" << dut.io_if_instr_1
-          << " instr2=0x" << dut.io_if_instr_2
-          << " instr3=0x" << dut.io_if_instr_3
-          << " ft=" << static_cast<unsigned>(dut.io_fetchThread);
-      }
-      log << std::dec << '\n';
-    }
-
-    if (completed) {
-      break;
-    }
+  static uint8_t traceFlags(const SimOptions& options) {
+    return options.trace_detail ? trace::kHeaderTracePc : 0;
   }
 
-  if (!completed) {
-    std::cerr << "Simulation terminated: max cycles reached" << std::endl;
-    return 3;
+  static void traceCtrl(const Model& dut, Record& record) {
+    record.flags |= trace::kTetraCtrl;
+    record.ctrl_thread = dut.io_ctrlThread;
+    record.ctrl_kind = (dut.io_ctrlIsBranch ? trace::kCtrlBranch : 0) |
+                       (dut.io_ctrlIsJal ? trace::kCtrlJal : 0) |
+                       (dut.io_ctrlIsJalr ? trace::kCtrlJalr : 0);
+    record.ctrl_from = dut.io_ctrlFromPC;
+    record.ctrl_target = dut.io_ctrlTarget;
   }
 
-  if (tohost_value != 1) {
-    std::cerr << "Test reported failure, tohost=0x" << std::hex << tohost_value << std::dec << std::endl;
+  static bool traceReset(const Model& dut, Record& record) {
+    if (!dut.io_ctrlTaken) {
+      return false;
+    }
+    record.flags = trace::kTetraReset;
+    traceCtrl(dut, record);
+    return true;
   }
 
-  try {
-    memory.dumpSignature(symbols.begin_signature, symbols.end_signature, options.signature);
-  } catch (const std::exception& e) {
-    std::cerr << "Signature dump failed: " << e.what() << std::endl;
-    return 4;
+  static void traceCycle(const Model& dut, const SimOptions& options, const FetchState&,
+                         const MemWrite& write, Record& record) {
+    record.enables = static_cast<uint8_t>(dut.io_threadEnable_0 | (dut.io_threadEnable_1 << 1) |
+                                          (dut.io_threadEnable_2 << 2) |
+                                          (dut.io_threadEnable_3 << 3));
+    record.fetch_thread = dut.io_fetchThread;
+    record.mem_mask = static_cast<uint8_t>(write.mask);
+    record.mem_addr = write.addr;
+    if (options.trace_detail) {
+      record.instr[0] = dut.io_if_instr_0;
+      record.instr[1] = dut.io_if_instr_1;
+      record.instr[2] = dut.io_if_instr_2;
+      record.instr[3] = dut.io_if_instr_3;
+    }
+    if (dut.io_ctrlTaken) {
+      traceCtrl(dut, record);
+    }
   }
+};
+}  // namespace
 
-  return tohost_value == 1 ? 0 : 5;
-}
+int main(int argc, char** argv) { return simMain<TetraNyteTraits>(argc, argv); }
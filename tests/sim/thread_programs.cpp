@@ -0,0 +1,113 @@
+#include "thread_programs.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t kT0 = 5;
+
+std::string hex(uint32_t value) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "0x%08x", value);
+  return buf;
+}
+
+// lui t0, hi(target); jalr x0, lo(target)(t0)
+void writeBootStub(Memory& memory, uint32_t addr, uint32_t target) {
+  const uint32_t hi = (target + 0x800) & 0xFFFFF000u;
+  const uint32_t lo = (target - hi) & 0xFFFu;
+  memory.write32(addr, hi | (kT0 << 7) | 0x37);
+  memory.write32(addr + 4, (lo << 20) | (kT0 << 15) | 0x67);
+}
+
+bool overlaps(uint32_t a_low, uint32_t a_high, uint32_t b_low, uint32_t b_high) {
+  return a_low < b_high && b_low < a_high;
+}
+
+}  // namespace
+
+ThreadPrograms::ThreadPrograms(const std::vector<ThreadElf>& elfs, unsigned num_threads,
+                               uint32_t reset_pc, Memory& memory, const std::string& image_cache)
+    : num_threads_(num_threads), reset_pc_(reset_pc), remaining_(elfs.size()) {
+  const uint32_t boot_high = kBootBase + kBootBytes * num_threads;
+  for (const ThreadElf& elf : elfs) {
+    Program program{elf.thread, elf.path, {}, {}, 0};
+    try {
+      loadElfIntoMemory(elf.path, memory, program.symbols, image_cache, program.layout);
+    } catch (const std::exception& e) {
+      throw std::runtime_error(elf.path + ": " + e.what());
+    }
+
+    const ElfLayout& layout = program.layout;
+    if (overlaps(layout.low, layout.high, kBootBase, boot_high)) {
+      throw std::runtime_error(elf.path + " overlaps the boot stubs at " + hex(kBootBase));
+    }
+    for (const Program& other : programs_) {
+      if (overlaps(layout.low, layout.high, other.layout.low, other.layout.high)) {
+        throw std::runtime_error("thread " + std::to_string(elf.thread) + " window " +
+                                 hex(layout.low) + ".." + hex(layout.high) + " overlaps thread " +
+                                 std::to_string(other.thread) + "'s");
+      }
+    }
+
+    if (layout.entry != reset_pc) {
+      writeBootStub(memory, kBootBase + kBootBytes * elf.thread, layout.entry);
+      booting_ |= 1u << elf.thread;
+    }
+    programs_.push_back(program);
+  }
+}
+
+void ThreadPrograms::bootPcs(const uint32_t* pcs, uint32_t* fetch_pcs) const {
+  for (unsigned t = 0; t < num_threads_; ++t) {
+    fetch_pcs[t] = pcs[t];
+    if (((booting_ >> t) & 0x1) && pcs[t] - reset_pc_ < kBootBytes) {
+      fetch_pcs[t] = kBootBase + kBootBytes * t + (pcs[t] - reset_pc_);
+    }
+  }
+}
+
+void ThreadPrograms::observePcs(const uint32_t* pcs) {
+  for (const Program& program : programs_) {
+    if (pcs[program.thread] == program.layout.entry) {
+      booting_ &= ~(1u << program.thread);
+    }
+  }
+}
+
+bool ThreadPrograms::store(uint32_t addr, uint32_t data) {
+  if (data == 0) {
+    return false;
+  }
+  for (Program& program : programs_) {
+    if (addr == program.symbols.tohost && program.tohost_value == 0) {
+      program.tohost_value = data;
+      --remaining_;
+    }
+  }
+  return remaining_ == 0;
+}
+
+int ThreadPrograms::finish(const Memory& memory, const std::string& signature,
+                           bool binary) const {
+  bool passed = true;
+  for (const Program& program : programs_) {
+    if (program.tohost_value != 1) {
+      std::cerr << "Thread " << program.thread << " (" << program.path
+                << ") reported failure, tohost=" << hex(program.tohost_value) << std::endl;
+      passed = false;
+    }
+  }
+  for (const Program& program : programs_) {
+    try {
+      writeSignature(memory, program.symbols.begin_signature, program.symbols.end_signature,
+                     signature + ".t" + std::to_string(program.thread), binary);
+    } catch (const std::exception& e) {
+      std::cerr << "Signature dump failed: " << e.what() << std::endl;
+      return 4;
+    }
+  }
+  return passed ? 0 : 5;
+}
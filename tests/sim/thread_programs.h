@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "elf_loader.h"
+#include "memory.h"
+#include "signature.h"
+#include "sim_options.h"
+
+// Separate programs per hardware thread, for --thread-elf. Each ELF is loaded
+// into the shared memory and must occupy its own window; windows may not
+// overlap. Each program keeps its own tohost and signature region. The run
+// is complete once every program has written its tohost.
+//
+// The cores reset every thread to the same PC, so a thread whose entry point
+// differs is started through a boot stub, much like spike's boot ROM:
+// fetches at the reset PC and the word after it are served from a two
+// instruction sequence (lui t0; jalr x0, t0) placed outside the memory
+// window at kBootBase, until the thread's PC reaches its entry. The stub
+// clobbers t0.
+class ThreadPrograms {
+ public:
+  static constexpr uint32_t kBootBase = 0x1000;
+  static constexpr uint32_t kBootBytes = 8;  // per thread
+
+  // Loads the programs and writes the boot stubs. Throws std::runtime_error
+  // on a load failure or overlapping windows.
+  ThreadPrograms(const std::vector<ThreadElf>& elfs, unsigned num_threads, uint32_t reset_pc,
+                 Memory& memory, const std::string& image_cache);
+
+  // Symbols of the first program, for the trace header.
+  const ElfSymbols& firstSymbols() const { return programs_.front().symbols; }
+
+  // True while any thread is still in its boot stub.
+  bool booting() const { return booting_ != 0; }
+
+  // Copies `pcs` to `fetch_pcs`, redirecting booting threads' reset-vector
+  // fetches into their stub.
+  void bootPcs(const uint32_t* pcs, uint32_t* fetch_pcs) const;
+
+  // Marks threads whose PC reached their entry point as booted.
+  void observePcs(const uint32_t* pcs);
+
+  // Records a store; returns true once every program has written tohost.
+  bool store(uint32_t addr, uint32_t data);
+
+  // Reports each program's result and dumps its signature to
+  // `<signature>.t<N>`. Returns 0 when all passed, 4 if a signature dump
+  // failed, otherwise 5.
+  int finish(const Memory& memory, const std::string& signature, bool binary) const;
+
+ private:
+  struct Program {
+    unsigned thread;
+    std::string path;
+    ElfSymbols symbols;
+    ElfLayout layout;
+    uint32_t tohost_value;
+  };
+
+  unsigned num_threads_;
+  uint32_t reset_pc_;
+  std::vector<Program> programs_;
+  uint32_t booting_ = 0;  // bit per thread
+  size_t remaining_;      // programs that have not written tohost
+};
@@ -0,0 +1,225 @@
+// Prints a binary --log or --flight-recorder trace in the text format the
+// harnesses used to write directly, one line per event:
+//   trace_decode <trace> > run.log
+// gzip and zstd compressed traces are recognized by their magic bytes.
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "trace_format.h"
+
+namespace {
+
+std::string shellQuote(const std::string& s) {
+  std::string quoted = "'";
+  for (char c : s) {
+    if (c == '\'') {
+      quoted += "'\\''";
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "'";
+}
+
+// Owns the input stream; compressed traces are read through a decompressor.
+class TraceInput {
+ public:
+  explicit TraceInput(const std::string& path) {
+    file_ = std::fopen(path.c_str(), "rb");
+    if (file_ == nullptr) {
+      throw std::runtime_error("cannot open " + path);
+    }
+    unsigned char magic[4] = {};
+    const size_t got = std::fread(magic, 1, sizeof(magic), file_);
+    const bool gzip = got >= 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+    const bool zstd = got == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f &&
+                      magic[3] == 0xfd;
+    if (!gzip && !zstd) {
+      std::rewind(file_);
+      return;
+    }
+    std::fclose(file_);
+    const std::string command = gzip ? "gzip -dc " : "zstd -dcq ";
+    file_ = ::popen((command + shellQuote(path)).c_str(), "r");
+    piped_ = true;
+    if (file_ == nullptr) {
+      throw std::runtime_error("cannot run " + command + "on " + path);
+    }
+  }
+
+  ~TraceInput() { piped_ ? ::pclose(file_) : std::fclose(file_); }
+
+  TraceInput(const TraceInput&) = delete;
+  TraceInput& operator=(const TraceInput&) = delete;
+
+  // Reads one record; returns false at a clean end of file and throws on a
+  // truncated record.
+  template <typename T>
+  bool read(T& value) {
+    const size_t got = std::fread(&value, 1, sizeof(value), file_);
+    if (got == 0) {
+      return false;
+    }
+    if (got != sizeof(value)) {
+      throw std::runtime_error("truncated trace record");
+    }
+    return true;
+  }
+
+ private:
+  FILE* file_ = nullptr;
+  bool piped_ = false;
+};
+
+unsigned bit(uint8_t kind, uint8_t mask) {
+  return (kind & mask) != 0 ? 1 : 0;
+}
+
+void decodeZeroNyte(TraceInput& in) {
+  trace::ZeroNyteRecord record;
+  uint64_t cycle = 0;
+  uint32_t pc = 0;
+  while (in.read(record)) {
+    cycle += record.cycle_delta;
+    pc += record.pc_delta[0];
+    std::printf("cycle=0x%" PRIx64 " pc=0x%x instr=0x%x result=0x%x\n", cycle, pc, record.instr,
+                record.result);
+  }
+}
+
+void printTetraCtrl(const trace::TetraNyteRecord& record) {
+  std::printf("ctrl: taken=1 thread=%x from=0x%x target=0x%x branch=%x jal=%x jalr=%x\n",
+              record.ctrl_thread, record.ctrl_from, record.ctrl_target,
+              bit(record.ctrl_kind, trace::kCtrlBranch), bit(record.ctrl_kind, trace::kCtrlJal),
+              bit(record.ctrl_kind, trace::kCtrlJalr));
+}
+
+void decodeTetraNyte(TraceInput& in, const trace::FileHeader& header) {
+  trace::TetraNyteRecord record;
+  uint64_t cycle = 0;
+  uint32_t pcs[4] = {};
+  while (in.read(record)) {
+    if (record.flags & trace::kTetraReset) {
+      printTetraCtrl(record);
+      continue;
+    }
+    cycle += record.cycle_delta;
+    for (int t = 0; t < 4; ++t) {
+      pcs[t] += record.pc_delta[t];
+    }
+    std::printf("pcs post-eval: pc0=0x%x pc1=0x%x pc2=0x%x pc3=0x%x en=[%u%u%u%u]\n", pcs[0],
+                pcs[1], pcs[2], pcs[3], bit(record.enables, 1), bit(record.enables, 2),
+                bit(record.enables, 4), bit(record.enables, 8));
+    if (record.flags & trace::kTetraCtrl) {
+      printTetraCtrl(record);
+    }
+    std::printf("cycle=0x%" PRIx64 " memAddr=0x%x mask=0x%x tohost=0x%x", cycle, record.mem_addr,
+                record.mem_mask, header.tohost);
+    if (header.flags & trace::kHeaderTracePc) {
+      std::printf(
+          " pc0=0x%x pc1=0x%x pc2=0x%x pc3=0x%x instr0=0x%x instr1=0x%x instr2=0x%x instr3=0x%x "
+          "ft=%x",
+          pcs[0], pcs[1], pcs[2], pcs[3], record.instr[0], record.instr[1], record.instr[2],
+          record.instr[3], record.fetch_thread);
+    }
+    std::printf("\n");
+  }
+}
+
+void decodeOctoNyte(TraceInput& in, const trace::FileHeader& header) {
+  trace::OctoNyteRecord record;
+  uint64_t cycle = 0;
+  uint32_t pcs[8] = {};
+  while (in.read(record)) {
+    cycle += record.cycle_delta;
+    for (int t = 0; t < 8; ++t) {
+      pcs[t] += record.pc_delta[t];
+    }
+    std::printf(
+        "cycle=0x%" PRIx64
+        " fetchThread=0x%x fetchValid=%u pc0=0x%x pc1=0x%x pc2=0x%x pc3=0x%x pc4=0x%x pc5=0x%x "
+        "pc6=0x%x pc7=0x%x memAddr=0x%x memMask=0x%x\n",
+        cycle, record.fetch_thread, bit(record.flags, trace::kOctoFetchValid), pcs[0], pcs[1],
+        pcs[2], pcs[3], pcs[4], pcs[5], pcs[6], pcs[7], record.mem_addr, record.mem_mask);
+    if (header.flags & trace::kHeaderTraceStage) {
+      // sN=<thread> for a valid stage, sN=- for a bubble.
+      std::printf("stages:");
+      for (int stage = 0; stage < 8; ++stage) {
+        if (record.stage_valids & (1u << stage)) {
+          std::printf(" s%d=%x", stage, record.stage_threads[stage]);
+        } else {
+          std::printf(" s%d=-", stage);
+        }
+      }
+      std::printf("\n");
+    }
+    if (record.flags & trace::kOctoExec) {
+      std::printf(
+          "exec1: thread=0x%x pc=0x%x instr=0x%x rs1=0x%x rs2=0x%x op=0x%x taken=%x target=0x%x "
+          "branch=%x jal=%x jalr=%x\n",
+          record.exec_thread, record.exec_pc, record.exec_instr, record.exec_rs1, record.exec_rs2,
+          record.exec_op, bit(record.exec_kind, trace::kCtrlTaken), record.exec_target,
+          bit(record.exec_kind, trace::kCtrlBranch), bit(record.exec_kind, trace::kCtrlJal),
+          bit(record.exec_kind, trace::kCtrlJalr));
+    }
+    if (record.flags & trace::kOctoWb) {
+      std::printf(
+          "wb: thread=0x%x from=0x%x instr=0x%x taken=%x target=0x%x branch=%x jal=%x jalr=%x\n",
+          record.wb_thread, record.wb_from, record.wb_instr, bit(record.wb_kind, trace::kCtrlTaken),
+          record.wb_target, bit(record.wb_kind, trace::kCtrlBranch),
+          bit(record.wb_kind, trace::kCtrlJal), bit(record.wb_kind, trace::kCtrlJalr));
+    }
+  }
+}
+
+size_t recordSize(uint8_t core) {
+  switch (core) {
+    case trace::kZeroNyte:
+      return sizeof(trace::ZeroNyteRecord);
+    case trace::kTetraNyte:
+      return sizeof(trace::TetraNyteRecord);
+    case trace::kOctoNyte:
+      return sizeof(trace::OctoNyteRecord);
+  }
+  throw std::runtime_error("unknown core id " + std::to_string(core));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <trace>" << std::endl;
+    return 1;
+  }
+
+  try {
+    TraceInput in(argv[1]);
+    trace::FileHeader header;
+    if (!in.read(header) || std::memcmp(header.magic, trace::kMagic, sizeof(trace::kMagic)) != 0) {
+      throw std::runtime_error("not a Nyte trace file");
+    }
+    if (header.record_size != recordSize(header.core)) {
+      throw std::runtime_error("record size mismatch; trace written by a different version");
+    }
+
+    switch (header.core) {
+      case trace::kZeroNyte:
+        decodeZeroNyte(in);
+        break;
+      case trace::kTetraNyte:
+        decodeTetraNyte(in, header);
+        break;
+      case trace::kOctoNyte:
+        decodeOctoNyte(in, header);
+        break;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Trace decode failed: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary cycle trace written by the harnesses' --log and --flight-recorder
+// options and read back by trace_decode. A file is a FileHeader followed by
+// one fixed-size record per logged cycle; the record type is selected by
+// FileHeader::core. Cycles are stored as deltas from the previous record and
+// PCs as (wrapping) deltas from the previous record's PC for the same thread,
+// so long runs are dominated by small repeated values and compress well.
+// Every record type names its PC array pc_delta so TraceSink can encode them
+// generically.
+namespace trace {
+
+constexpr char kMagic[8] = {'N', 'Y', 'T', 'E', 'T', 'R', 'C', '1'};
+
+enum Core : uint8_t {
+  kZeroNyte = 0,
+  kTetraNyte = 1,
+  kOctoNyte = 2,
+};
+
+enum HeaderFlags : uint8_t {
+  kHeaderTracePc = 1u << 0,     // TetraNyte --trace-pc: instr[] fields are valid
+  kHeaderTraceStage = 1u << 1,  // OctoNyte: print the per-stage thread/valid state
+};
+
+struct FileHeader {
+  char magic[8];
+  uint8_t core;
+  uint8_t num_threads;
+  uint8_t flags;
+  uint8_t record_size;
+  uint32_t tohost;
+};
+
+// Control-flow kind bits shared by the TetraNyte ctrl and OctoNyte exec/wb
+// sub-records.
+enum CtrlKind : uint8_t {
+  kCtrlBranch = 1u << 0,
+  kCtrlJal = 1u << 1,
+  kCtrlJalr = 1u << 2,
+  kCtrlTaken = 1u << 3,
+};
+
+struct ZeroNyteRecord {
+  uint32_t cycle_delta;
+  uint32_t pc_delta[1];
+  uint32_t instr;
+  uint32_t result;
+};
+
+enum TetraNyteFlags : uint8_t {
+  kTetraReset = 1u << 0,  // reset-phase record: only the ctrl fields are valid
+  kTetraCtrl = 1u << 1,   // io_ctrlTaken was set
+};
+
+struct TetraNyteRecord {
+  uint32_t cycle_delta;
+  uint8_t flags;
+  uint8_t enables;  // bit i = io_threadEnable_i
+  uint8_t fetch_thread;
+  uint8_t mem_mask;
+  uint32_t pc_delta[4];
+  uint32_t mem_addr;
+  uint32_t instr[4];
+  uint8_t ctrl_thread;
+  uint8_t ctrl_kind;
+  uint16_t reserved;
+  uint32_t ctrl_from;
+  uint32_t ctrl_target;
+};
+
+enum OctoNyteFlags : uint8_t {
+  kOctoFetchValid = 1u << 0,
+  kOctoExec = 1u << 1,  // exec-stage control-flow record present
+  kOctoWb = 1u << 2,    // writeback control-flow record present
+};
+
+struct OctoNyteRecord {
+  uint32_t cycle_delta;
+  uint8_t flags;
+  uint8_t fetch_thread;
+  uint8_t mem_mask;
+  uint8_t stage_valids;  // bit i = io_debugStageValids_i
+  uint8_t stage_threads[8];
+  uint32_t pc_delta[8];
+  uint32_t mem_addr;
+
+  uint8_t exec_thread;
+  uint8_t exec_op;
+  uint8_t exec_kind;
+  uint8_t reserved1;
+  uint32_t exec_pc;
+  uint32_t exec_instr;
+  uint32_t exec_rs1;
+  uint32_t exec_rs2;
+  uint32_t exec_target;
+
+  uint8_t wb_thread;
+  uint8_t wb_kind;
+  uint16_t reserved2;
+  uint32_t wb_from;
+  uint32_t wb_instr;
+  uint32_t wb_target;
+};
+
+}  // namespace trace
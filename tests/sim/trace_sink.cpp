@@ -0,0 +1,90 @@
+#include "trace_sink.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace {
+
+constexpr size_t kMaxRecorders = 256;
+
+// Lock-free so the signal handler can walk it while workers register and
+// unregister. A full table only means the extra recorders miss signal dumps.
+std::atomic<FlightRecorderBase*> g_recorders[kMaxRecorders];
+std::atomic_flag g_dumping = ATOMIC_FLAG_INIT;
+
+void onSignal(int signo) {
+  if (!g_dumping.test_and_set()) {
+    for (auto& slot : g_recorders) {
+      if (FlightRecorderBase* recorder = slot.load(std::memory_order_acquire)) {
+        recorder->dump();
+      }
+    }
+  }
+  // SA_RESETHAND restored the default action; let it terminate the process.
+  ::raise(signo);
+}
+
+}  // namespace
+
+void registerFlightRecorder(FlightRecorderBase* recorder) {
+  for (auto& slot : g_recorders) {
+    FlightRecorderBase* expected = nullptr;
+    if (slot.compare_exchange_strong(expected, recorder, std::memory_order_acq_rel)) {
+      return;
+    }
+  }
+}
+
+void unregisterFlightRecorder(FlightRecorderBase* recorder) {
+  for (auto& slot : g_recorders) {
+    FlightRecorderBase* expected = recorder;
+    if (slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+      return;
+    }
+  }
+}
+
+void installFlightRecorderSignalHandlers() {
+  struct sigaction action = {};
+  action.sa_handler = onSignal;
+  action.sa_flags = SA_RESETHAND;
+  sigemptyset(&action.sa_mask);
+  for (int signo : {SIGINT, SIGTERM, SIGSEGV, SIGBUS, SIGFPE, SIGABRT}) {
+    ::sigaction(signo, &action, nullptr);
+  }
+}
+
+int createTraceFile(const char* path, const trace::FileHeader& header) {
+  const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+  if (!writeFully(fd, &header, sizeof(header))) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool writeFully(int fd, const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  while (size != 0) {
+    const ssize_t written = ::write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+bool closeTraceFile(int fd) {
+  return ::close(fd) == 0;
+}
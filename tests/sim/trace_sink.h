@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "trace_format.h"
+#include "trace_writer.h"
+
+// Anything the fatal-signal handler must flush before the process dies.
+class FlightRecorderBase {
+ public:
+  virtual ~FlightRecorderBase() = default;
+
+  // Writes the retained records to disk and returns false on error. Must only
+  // use async-signal-safe calls, since it also runs from the signal handler.
+  virtual bool dump() const = 0;
+};
+
+void registerFlightRecorder(FlightRecorderBase* recorder);
+void unregisterFlightRecorder(FlightRecorderBase* recorder);
+
+// Installs SIGINT, SIGTERM, SIGSEGV, SIGBUS, SIGFPE and SIGABRT handlers that
+// dump every registered flight recorder and then re-raise the signal with its
+// default action. Records being written by another thread at that moment may
+// come out torn; everything older is intact.
+void installFlightRecorderSignalHandlers();
+
+// Async-signal-safe file helpers for dump(). createTraceFile truncates
+// `path`, writes `header` and returns the descriptor, or -1 on error.
+int createTraceFile(const char* path, const trace::FileHeader& header);
+bool writeFully(int fd, const void* data, size_t size);
+bool closeTraceFile(int fd);
+
+// Destination for one test's per-cycle records. Depending on the options it
+// streams every record through a TraceWriter (--log), keeps only the most
+// recent ones in a preallocated ring that is written out when the test fails
+// or the process is signalled (--flight-recorder N), or drops them.
+template <typename Record>
+class TraceSink final : public FlightRecorderBase {
+ public:
+  TraceSink() = default;
+  ~TraceSink() override { unregisterFlightRecorder(this); }
+
+  TraceSink(const TraceSink&) = delete;
+  TraceSink& operator=(const TraceSink&) = delete;
+
+  // With flight_depth == 0, streams to `log_path` if it is non-empty. With
+  // flight_depth > 0, the last flight_depth cycles are dumped to `log_path`,
+  // or to "<signature_path>.flight.trace" when no log was requested. Throws
+  // std::runtime_error if the streaming log cannot be opened.
+  void open(const std::string& log_path, const std::string& signature_path, size_t flight_depth,
+            const trace::FileHeader& header) {
+    header_ = header;
+    if (flight_depth == 0) {
+      if (!log_path.empty()) {
+        writer_.open(log_path, header);
+      }
+      return;
+    }
+    dump_path_ = log_path.empty() ? signature_path + ".flight.trace" : log_path;
+    ring_.assign(flight_depth, Entry{});
+    count_.store(0, std::memory_order_relaxed);
+    registerFlightRecorder(this);
+  }
+
+  bool enabled() const { return writer_.isOpen() || !ring_.empty(); }
+
+  // Records one simulated cycle. On entry `record.pc_delta` holds absolute
+  // PCs and `cycle_delta` is ignored; both are delta-encoded here.
+  void cycle(uint64_t cycle, const Record& record) { push(cycle, true, record); }
+
+  // Records an event outside the cycle stream (such as a TetraNyte
+  // reset-phase ctrl record); its cycle and PC fields are left untouched.
+  void event(const Record& record) { push(0, false, record); }
+
+  // Ends the test: closes the streaming log, or dumps the flight ring when
+  // `exit_code` is non-zero.
+  void finish(int exit_code) {
+    writer_.close();
+    if (!ring_.empty()) {
+      unregisterFlightRecorder(this);
+      if (exit_code != 0) {
+        if (dump()) {
+          std::cerr << "Flight recorder written to " << dump_path_ << std::endl;
+        } else {
+          std::cerr << "Flight recorder dump failed: " << dump_path_ << std::endl;
+        }
+      }
+    }
+  }
+
+  bool dump() const override {
+    const size_t count = count_.load(std::memory_order_acquire);
+    const size_t depth = ring_.size();
+    const size_t first = count > depth ? count - depth : 0;
+
+    const int fd = createTraceFile(dump_path_.c_str(), header_);
+    if (fd < 0) {
+      return false;
+    }
+
+    // Re-encode the retained window from zero, batching records into a
+    // stack buffer to keep the number of write calls down.
+    constexpr size_t kBatch = 64;
+    Record batch[kBatch];
+    size_t batched = 0;
+    Encoder encoder;
+    bool ok = true;
+    for (size_t i = first; i < count && ok; ++i) {
+      const Entry& entry = ring_[i % depth];
+      batch[batched] = entry.record;
+      if (entry.has_state) {
+        encoder.encode(entry.cycle, batch[batched]);
+      }
+      if (++batched == kBatch) {
+        ok = writeFully(fd, batch, sizeof(batch));
+        batched = 0;
+      }
+    }
+    if (ok && batched != 0) {
+      ok = writeFully(fd, batch, batched * sizeof(Record));
+    }
+    return closeTraceFile(fd) && ok;
+  }
+
+ private:
+  struct Entry {
+    uint64_t cycle = 0;
+    bool has_state = false;
+    Record record{};
+  };
+
+  // Running state for turning absolute cycles and PCs into deltas.
+  struct Encoder {
+    static constexpr size_t kPcs = sizeof(Record::pc_delta) / sizeof(Record::pc_delta[0]);
+
+    void encode(uint64_t cycle, Record& record) {
+      record.cycle_delta = static_cast<uint32_t>(cycle - last_cycle);
+      last_cycle = cycle;
+      for (size_t i = 0; i < kPcs; ++i) {
+        const uint32_t pc = record.pc_delta[i];
+        record.pc_delta[i] = pc - last_pcs[i];
+        last_pcs[i] = pc;
+      }
+    }
+
+    uint64_t last_cycle = 0;
+    uint32_t last_pcs[kPcs] = {};
+  };
+
+  void push(uint64_t cycle, bool has_state, const Record& record) {
+    if (writer_.isOpen()) {
+      Record encoded = record;
+      if (has_state) {
+        stream_encoder_.encode(cycle, encoded);
+      }
+      writer_.write(encoded);
+      return;
+    }
+    if (ring_.empty()) {
+      return;
+    }
+    const size_t count = count_.load(std::memory_order_relaxed);
+    Entry& entry = ring_[count % ring_.size()];
+    entry.cycle = cycle;
+    entry.has_state = has_state;
+    entry.record = record;
+    count_.store(count + 1, std::memory_order_release);
+  }
+
+  trace::FileHeader header_{};
+  TraceWriter writer_;
+  Encoder stream_encoder_;
+  std::vector<Entry> ring_;
+  std::atomic<size_t> count_{0};
+  std::string dump_path_;
+};
@@ -0,0 +1,112 @@
+#include "trace_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+  return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string shellQuote(const std::string& s) {
+  std::string quoted = "'";
+  for (char c : s) {
+    if (c == '\'') {
+      quoted += "'\\''";
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "'";
+}
+
+}  // namespace
+
+TraceWriter::~TraceWriter() {
+  close();
+}
+
+void TraceWriter::open(const std::string& path, const trace::FileHeader& header) {
+  close();
+
+  if (endsWith(path, ".gz")) {
+    out_ = ::popen(("gzip -1 -c > " + shellQuote(path)).c_str(), "w");
+    piped_ = true;
+  } else if (endsWith(path, ".zst")) {
+    out_ = ::popen(("zstd -q -1 -f -o " + shellQuote(path)).c_str(), "w");
+    piped_ = true;
+  } else {
+    out_ = std::fopen(path.c_str(), "wb");
+    piped_ = false;
+  }
+  if (out_ == nullptr) {
+    throw std::runtime_error("cannot open trace " + path + ": " + std::strerror(errno));
+  }
+
+  path_ = path;
+  failed_ = false;
+  ring_.resize(kRingBytes);
+  head_.store(0, std::memory_order_relaxed);
+  tail_.store(0, std::memory_order_relaxed);
+  closing_.store(false, std::memory_order_relaxed);
+  write(header);
+  thread_ = std::thread(&TraceWriter::drain, this);
+}
+
+void TraceWriter::append(const void* data, size_t size) {
+  const size_t head = head_.load(std::memory_order_relaxed);
+  while (kRingBytes - (head - tail_.load(std::memory_order_acquire)) < size) {
+    std::this_thread::yield();  // writer is behind; wait rather than drop records
+  }
+  const size_t offset = head & (kRingBytes - 1);
+  const size_t first = std::min(size, kRingBytes - offset);
+  std::memcpy(ring_.data() + offset, data, first);
+  std::memcpy(ring_.data(), static_cast<const uint8_t*>(data) + first, size - first);
+  head_.store(head + size, std::memory_order_release);
+}
+
+void TraceWriter::drain() {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  for (;;) {
+    // Sample closing_ before head_ so the final records are never missed.
+    const bool closing = closing_.load(std::memory_order_acquire);
+    const size_t head = head_.load(std::memory_order_acquire);
+    if (head == tail) {
+      if (closing) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      continue;
+    }
+    while (tail != head) {
+      const size_t offset = tail & (kRingBytes - 1);
+      const size_t chunk = std::min(head - tail, kRingBytes - offset);
+      if (!failed_ && std::fwrite(ring_.data() + offset, 1, chunk, out_) != chunk) {
+        failed_ = true;
+      }
+      tail += chunk;
+      tail_.store(tail, std::memory_order_release);
+    }
+  }
+}
+
+void TraceWriter::close() {
+  if (out_ == nullptr) {
+    return;
+  }
+  closing_.store(true, std::memory_order_release);
+  thread_.join();
+
+  const int status = piped_ ? ::pclose(out_) : std::fclose(out_);
+  out_ = nullptr;
+  if (failed_ || status != 0) {
+    std::cerr << "Trace write failed: " << path_ << std::endl;
+  }
+  ring_.clear();
+  ring_.shrink_to_fit();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace_format.h"
+
+// Streams binary trace records (see trace_format.h) to a file without
+// blocking the simulation loop on I/O. The simulation thread copies each
+// record into a single-producer/single-consumer ring buffer; a background
+// thread drains the ring to disk. A path ending in ".gz" or ".zst" is piped
+// through gzip or zstd instead of being written raw.
+class TraceWriter {
+ public:
+  TraceWriter() = default;
+  ~TraceWriter();
+
+  TraceWriter(const TraceWriter&) = delete;
+  TraceWriter& operator=(const TraceWriter&) = delete;
+
+  // Opens `path`, queues `header` and starts the writer thread. Throws
+  // std::runtime_error if the file (or compressor pipe) cannot be opened.
+  void open(const std::string& path, const trace::FileHeader& header);
+
+  bool isOpen() const { return out_ != nullptr; }
+
+  template <typename Record>
+  void write(const Record& record) {
+    append(&record, sizeof(record));
+  }
+
+  // Waits for the ring to drain and closes the file. Write errors are
+  // reported on stderr. Called by the destructor.
+  void close();
+
+ private:
+  static constexpr size_t kRingBytes = size_t{1} << 22;
+
+  void append(const void* data, size_t size);
+  void drain();
+
+  std::vector<uint8_t> ring_;
+  // Monotonic byte counters; the ring offset is counter & (kRingBytes - 1).
+  alignas(64) std::atomic<size_t> head_{0};  // written by the producer
+  alignas(64) std::atomic<size_t> tail_{0};  // written by the writer thread
+  alignas(64) std::atomic<bool> closing_{false};
+  std::thread thread_;
+  std::string path_;
+  FILE* out_ = nullptr;
+  bool piped_ = false;
+  bool failed_ = false;
+};
+
+namespace trace {
+
+inline FileHeader makeHeader(Core core, uint8_t num_threads, uint8_t flags, uint8_t record_size,
+                             uint32_t tohost) {
+  FileHeader header{};
+  for (size_t i = 0; i < sizeof(kMagic); ++i) {
+    header.magic[i] = kMagic[i];
+  }
+  header.core = core;
+  header.num_threads = num_threads;
+  header.flags = flags;
+  header.record_size = record_size;
+  header.tohost = tohost;
+  return header;
+}
+
+}  // namespace trace
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#if NYTE_WAVE
+#include "verilated_fst_c.h"
+#endif
+
+// FST waveform capture for --wave, limited to a window of cycles so long runs
+// stay cheap: nothing is dumped outside [from, to), and the file is closed as
+// soon as the window ends. A window can also be opened later with trigger(),
+// for the PC and store triggers.
+//
+// Cycle c is dumped at time 2c after its low-phase evaluation and 2c+1 after
+// its rising edge. Like checkpoint.h, this header is compiled into each
+// harness main since it needs the Verilator runtime headers; the build
+// scripts define NYTE_WAVE for models verilated with --trace-fst, and without
+// it the constructor throws.
+template <typename Model>
+class WaveCapture {
+ public:
+  static constexpr uint64_t kNever = UINT64_MAX;
+
+  // Creates the file. The model's context must have tracing enabled
+  // (traceEverOn) before the model was constructed. Throws
+  // std::runtime_error if the file cannot be created.
+  WaveCapture(Model& model, const std::string& path, uint64_t from, uint64_t to)
+      : from_(from), to_(to) {
+#if NYTE_WAVE
+    model.trace(&fst_, 99);
+    fst_.open(path.c_str());
+    if (!fst_.isOpen()) {
+      throw std::runtime_error("cannot create " + path);
+    }
+#else
+    (void)model;
+    throw std::runtime_error("cannot write " + path +
+                             ": this simulator was built without FST tracing");
+#endif
+  }
+
+  WaveCapture(const WaveCapture&) = delete;
+  WaveCapture& operator=(const WaveCapture&) = delete;
+  ~WaveCapture() { close(); }
+
+  // Opens a `length` cycle window at `cycle` unless one was already set.
+  void trigger(uint64_t cycle, uint64_t length) {
+    if (from_ == kNever) {
+      from_ = cycle;
+      to_ = length > kNever - cycle ? kNever : cycle + length;
+    }
+  }
+
+  // Dumps `phase` (0 low, 1 high) of `cycle` if it lies in the window.
+  void dump(uint64_t cycle, int phase) {
+    if (cycle < from_) {
+      return;
+    }
+    if (cycle >= to_) {
+      close();
+      return;
+    }
+    captured_ = true;
+#if NYTE_WAVE
+    fst_.dump(cycle * 2 + static_cast<uint64_t>(phase));
+#else
+    (void)phase;
+#endif
+  }
+
+  // True once any cycle was dumped.
+  bool captured() const { return captured_; }
+
+  void close() {
+#if NYTE_WAVE
+    if (fst_.isOpen()) {
+      fst_.close();
+    }
+#endif
+  }
+
+ private:
+  uint64_t from_;
+  uint64_t to_;
+  bool captured_ = false;
+#if NYTE_WAVE
+  VerilatedFstC fst_;
+#endif
+};
@@ -1,150 +1,67 @@
 #include <cstdint>
-#include <fstream>
-#include <iostream>
-#include <stdexcept>
-#include <string>
 
 #include "VZeroNyteRV32ICore.h"
-#include "elf_loader.h"
-#include "memory.h"
-#include "verilated.h"
+#include "sim_main.h"
 
 namespace {
-struct Options {
-  std::string elf;
-  std::string signature;
-  std::string log;
-  uint64_t max_cycles = 1000000;
-};
-
-Options parseArgs(int argc, char** argv) {
-  Options opts;
-  for (int i = 1; i < argc; ++i) {
-    const std::string arg(argv[i]);
-    if (arg == "--elf" && i + 1 < argc) {
-      opts.elf = argv[++i];
-    } else if (arg == "--signature" && i + 1 < argc) {
-      opts.signature = argv[++i];
-    } else if (arg == "--log" && i + 1 < argc) {
-      opts.log = argv[++i];
-    } else if (arg == "--max-cycles" && i + 1 < argc) {
-      opts.max_cycles = std::stoull(argv[++i]);
-    } else {
-      throw std::invalid_argument("unknown or incomplete argument: " + arg);
-    }
-  }
-  if (opts.elf.empty() || opts.signature.empty()) {
-    throw std::invalid_argument("--elf and --signature are required");
-  }
-  return opts;
-}
-
-constexpr uint32_t kMemBase = 0x80000000u;
-constexpr uint32_t kMemSize = 16 * 1024 * 1024;
-constexpr int kResetCycles = 5;
-}  // namespace
-
-int main(int argc, char** argv) {
-  Verilated::commandArgs(argc, argv);
-
-  Options options;
-  try {
-    options = parseArgs(argc, argv);
-  } catch (const std::exception& e) {
-    std::cerr << "Argument error: " << e.what() << std::endl;
-    return 1;
+struct ZeroNyteTraits {
+  using Model = VZeroNyteRV32ICore;
+  using Record = trace::ZeroNyteRecord;
+  static constexpr char kName[] = "zeronyte";
+  static constexpr trace::Core kTraceCore = trace::kZeroNyte;
+  static constexpr int kNumThreads = 1;
+  static constexpr int kFetchWidth = 1;
+  static constexpr const char* kTraceDetailFlag = nullptr;
+  // The single-cycle datapath shows the instruction at pc_out, and what it
+  // writes back, before the edge that commits it.
+  static constexpr bool kRetireAtLowPhase = true;
+
+  struct FetchState {};
+
+  template <int T>
+  static uint32_t pc(const Model& dut) {
+    return dut.io_pc_out;
   }
 
-  std::ofstream log;
-  if (!options.log.empty()) {
-    log.open(options.log);
-  }
-
-  Memory memory(kMemBase, kMemSize);
-  ElfSymbols symbols;
+  static void driveStatic(Model&) {}
 
-  try {
-    loadElfIntoMemory(options.elf, memory, symbols);
-  } catch (const std::exception& e) {
-    std::cerr << "ELF load failed: " << e.what() << std::endl;
-    return 1;
+  // dmem_addr follows the fetched instruction, so it moves on the second
+  // drive of most cycles.
+  static bool drive(Model& dut, GuestBus& bus, ReadPorts& ports, uint32_t,
+                    const ThreadPcs<ZeroNyteTraits>&, FetchState&) {
+    const bool instr = driveInput(dut.io_imem_rdata, ports.instr.read(bus, dut.io_imem_addr));
+    const bool data = driveInput(dut.io_dmem_rdata, ports.data.read(bus, dut.io_dmem_addr));
+    return instr || data;
   }
 
-  VZeroNyteRV32ICore dut;
-
-  auto applyMemory = [&]() {
-    dut.io_imem_rdata = memory.read32(dut.io_imem_addr);
-    dut.io_dmem_rdata = memory.read32(dut.io_dmem_addr);
-  };
+  static unsigned fetchThread(const Model&, const FetchState&) { return 0; }
 
-  // Reset
-  dut.reset = 1;
-  for (int cycle = 0; cycle < kResetCycles; ++cycle) {
-    dut.clock = 0;
-    applyMemory();
-    dut.eval();
-    dut.clock = 1;
-    applyMemory();
-    dut.eval();
+  // Sub-word stores arrive already merged into the full word.
+  static MemWrite memWrite(const Model& dut) {
+    return {dut.io_dmem_addr, dut.io_dmem_wdata, dut.io_dmem_wen ? 0xfu : 0u};
   }
-  dut.reset = 0;
 
-  bool completed = false;
-  uint32_t tohost_value = 0;
-
-  for (uint64_t cycle = 0; cycle < options.max_cycles; ++cycle) {
-    dut.clock = 0;
-    applyMemory();
-    dut.eval();
-
-    dut.clock = 1;
-    applyMemory();
-    dut.eval();
-
-    if (dut.io_dmem_wen) {
-      const uint32_t addr = dut.io_dmem_addr;
-      const uint32_t data = dut.io_dmem_wdata;
-      try {
-        memory.write32(addr, data);
-      } catch (const std::exception& e) {
-        std::cerr << "Memory write failed at 0x" << std::hex << addr << ": " << e.what() << std::endl;
-        return 2;
-      }
-      if (addr == symbols.tohost && data != 0) {
-        tohost_value = data;
-        completed = true;
-      }
-    }
-
-    if (log.is_open()) {
-      log << std::hex
-          << "cycle=0x" << cycle
-          << " pc=0x" << dut.io_pc_out
-          << " instr=0x" << dut.io_instr_out
-          << " result=0x" << dut.io_result
-          << std::dec << '\n';
-    }
-
-    if (completed) {
-      break;
+  static bool retirement(const Model& dut, RetireEvent& event) {
+    if (!dut.io_retire) {
+      return false;  // a DIV/REM is still iterating
     }
+    event.pc = dut.io_pc_out;
+    event.instr = dut.io_instr_out;
+    event.rd = dut.io_rd_wen ? dut.io_rd_addr : 0;
+    event.data = dut.io_result;
+    return true;
   }
 
-  if (!completed) {
-    std::cerr << "Simulation terminated: max cycles reached" << std::endl;
-    return 3;
-  }
+  static uint8_t traceFlags(const SimOptions&) { return 0; }
 
-  if (tohost_value != 1) {
-    std::cerr << "Test reported failure, tohost=0x" << std::hex << tohost_value << std::dec << std::endl;
-  }
+  static bool traceReset(const Model&, Record&) { return false; }
 
-  try {
-    memory.dumpSignature(symbols.begin_signature, symbols.end_signature, options.signature);
-  } catch (const std::exception& e) {
-    std::cerr << "Signature dump failed: " << e.what() << std::endl;
-    return 4;
+  static void traceCycle(const Model& dut, const SimOptions&, const FetchState&, const MemWrite&,
+                         Record& record) {
+    record.instr = dut.io_instr_out;
+    record.result = dut.io_result;
   }
+};
+}  // namespace
 
-  return tohost_value == 1 ? 0 : 5;
-}
+int main(int argc, char** argv) { return simMain<ZeroNyteTraits>(argc, argv); }